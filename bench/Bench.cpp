@@ -0,0 +1,278 @@
+#include "benchmark.h"
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <selene.h>
+#include <string>
+
+// Count every C++ heap allocation made while a benchmark runs
+void *operator new(std::size_t size) {
+    ++bench::allocations();
+    if (void *ptr = std::malloc(size == 0 ? 1 : size)) {
+        return ptr;
+    }
+    throw std::bad_alloc{};
+}
+
+void operator delete(void *ptr) noexcept {
+    std::free(ptr);
+}
+
+namespace {
+
+struct Point {
+    int x;
+    int y;
+    Point(int x_, int y_) : x(x_), y(y_) {}
+
+    int Sum() const {
+        return x + y;
+    }
+
+    void Move(int dx) {
+        x += dx;
+    }
+};
+
+struct Counter {
+    int count = 0;
+
+    void Add(int n) {
+        count += n;
+    }
+};
+
+int add(int a, int b) {
+    return a + b;
+}
+
+int take_point(Point *p) {
+    return p->x;
+}
+
+std::string echo(std::string s) {
+    return s;
+}
+
+const long kOps = 1000000;
+
+template <typename Setup, typename Fun>
+void run_in(sel::State &state, const std::string &filter, const char *name,
+            long ops, Setup &&setup, Fun &&fun) {
+    setup(state);
+    bench::run(filter, name, ops, [&](long n) { fun(state, n); });
+}
+
+// Each benchmark gets a fresh state so that earlier runs cannot leave
+// garbage behind that a later one has to collect. The state is the
+// default configuration, so only C++ allocations are counted.
+template <typename Setup, typename Fun>
+void run(const std::string &filter, const char *name, long ops,
+         Setup &&setup, Fun &&fun) {
+    sel::State state{true};
+    run_in(state, filter, name, ops, setup, fun);
+}
+
+// Same with a state that allocates through a sel::Allocator, which also
+// counts the allocations made by Lua
+template <typename Setup, typename Fun>
+void run_with_allocator(const std::string &filter, const char *name, long ops,
+                        Setup &&setup, Fun &&fun) {
+    sel::State state{std::unique_ptr<sel::Allocator>(new bench::CountingAllocator), true};
+    run_in(state, filter, name, ops, setup, fun);
+}
+
+void noop_setup(sel::State &) {}
+
+// Runs the Lua function "loop" n times from within Lua
+void lua_loop(sel::State &state, long n) {
+    state["loop"](static_cast<int>(n));
+}
+
+void selector_benchmarks(const std::string &filter) {
+    run(filter, "selector read depth 1", kOps,
+        [](sel::State &state) { state("a = 1"); },
+        [](sel::State &state, long n) {
+            int sink = 0;
+            for (long i = 0; i < n; ++i) sink += int(state["a"]);
+            if (sink == -1) std::cout << sink;
+        });
+    run(filter, "selector read depth 3", kOps,
+        [](sel::State &state) { state("t = {u = {v = 1}}"); },
+        [](sel::State &state, long n) {
+            int sink = 0;
+            for (long i = 0; i < n; ++i) sink += int(state["t"]["u"]["v"]);
+            if (sink == -1) std::cout << sink;
+        });
+    run(filter, "selector write depth 1", kOps, noop_setup,
+        [](sel::State &state, long n) {
+            for (long i = 0; i < n; ++i) state["a"] = static_cast<int>(i);
+        });
+    run(filter, "selector write depth 3", kOps,
+        [](sel::State &state) { state("t = {u = {}}"); },
+        [](sel::State &state, long n) {
+            for (long i = 0; i < n; ++i) state["t"]["u"]["v"] = static_cast<int>(i);
+        });
+    run(filter, "bound selector read depth 3", kOps,
+        [](sel::State &state) { state("t = {u = {v = 1}}"); },
+        [](sel::State &state, long n) {
+            auto v = state["t"]["u"]["v"].Bind();
+            int sink = 0;
+            for (long i = 0; i < n; ++i) sink += v.Get<int>();
+            if (sink == -1) std::cout << sink;
+        });
+}
+
+void lua_call_benchmarks(const std::string &filter) {
+    auto setup = [](sel::State &state) {
+        state("function add(a, b) return a + b end");
+    };
+    run(filter, "Selector operator()", kOps, setup,
+        [](sel::State &state, long n) {
+            int sink = 0;
+            for (long i = 0; i < n; ++i) sink += int(state["add"](static_cast<int>(i), 1));
+            if (sink == -1) std::cout << sink;
+        });
+    run(filter, "Selector::Call", kOps, setup,
+        [](sel::State &state, long n) {
+            int sink = 0;
+            for (long i = 0; i < n; ++i) sink += state["add"].Call<int>(static_cast<int>(i), 1);
+            if (sink == -1) std::cout << sink;
+        });
+    run(filter, "sel::function", kOps, setup,
+        [](sel::State &state, long n) {
+            sel::function<int(int, int)> fun = state["add"];
+            int sink = 0;
+            for (long i = 0; i < n; ++i) sink += fun(static_cast<int>(i), 1);
+            if (sink == -1) std::cout << sink;
+        });
+    run(filter, "sel::function in batch", kOps, setup,
+        [](sel::State &state, long n) {
+            sel::function<int(int, int)> fun = state["add"];
+            auto batch = state.BatchCalls();
+            int sink = 0;
+            for (long i = 0; i < n; ++i) sink += fun(static_cast<int>(i), 1);
+            if (sink == -1) std::cout << sink;
+        });
+}
+
+void cpp_call_benchmarks(const std::string &filter) {
+    run(filter, "Lua->C++ function pointer", kOps,
+        [](sel::State &state) {
+            state["f"] = &add;
+            state("function loop(n) for i = 1, n do f(i, 1) end end");
+        }, lua_loop);
+    run(filter, "Lua->C++ SEL_FUN", kOps,
+        [](sel::State &state) {
+            state["f"] = SEL_FUN(&add);
+            state("function loop(n) for i = 1, n do f(i, 1) end end");
+        }, lua_loop);
+    run(filter, "Lua->C++ capturing lambda (Fun)", kOps,
+        [](sel::State &state) {
+            int offset = 1;
+            state["f"] = [offset](int a) { return a + offset; };
+            state("function loop(n) for i = 1, n do f(i) end end");
+        }, lua_loop);
+    run(filter, "Lua->C++ method (ClassFun)", kOps,
+        [](sel::State &state) {
+            state["Point"].SetClass<Point, int, int>("sum", &Point::Sum, "move", &Point::Move);
+            state("p = Point.new(1, 2)");
+            state("function loop(n) for i = 1, n do p:move(1) end end");
+        }, lua_loop);
+    run(filter, "Lua->C++ method (SEL_FUN)", kOps,
+        [](sel::State &state) {
+            state["Point"].SetClass<Point, int, int>("move", SEL_FUN(&Point::Move));
+            state("p = Point.new(1, 2)");
+            state("function loop(n) for i = 1, n do p:move(1) end end");
+        }, lua_loop);
+    run(filter, "Lua->C++ property read", kOps,
+        [](sel::State &state) {
+            state["Point"].SetClass<Point, int, int>("x", sel::property(&Point::x));
+            state("p = Point.new(1, 2)");
+            state("function loop(n) local s = 0 for i = 1, n do s = s + p.x end end");
+        }, lua_loop);
+    run(filter, "Lua->C++ object method (ObjFun)", kOps,
+        [](sel::State &state) {
+            static Counter counter;
+            state["counter"].SetObj(counter, "add", &Counter::Add);
+            state("function loop(n) for i = 1, n do counter.add(1) end end");
+        }, lua_loop);
+    run(filter, "Lua->C++ construct (Ctor)", kOps,
+        [](sel::State &state) {
+            state["Point"].SetClass<Point, int, int>();
+            state("function loop(n) for i = 1, n do Point.new(i, i) end end");
+        }, lua_loop);
+    run(filter, "Lua->C++ userdata type check", kOps,
+        [](sel::State &state) {
+            state["Point"].SetClass<Point, int, int>();
+            state["f"] = &take_point;
+            state("p = Point.new(1, 2)");
+            state("function loop(n) for i = 1, n do f(p) end end");
+        }, lua_loop);
+    run(filter, "Lua->C++ string round trip", kOps,
+        [](sel::State &state) {
+            state["f"] = &echo;
+            state("s = string.rep('x', 64)");
+            state("function loop(n) for i = 1, n do f(s) end end");
+        }, lua_loop);
+}
+
+void error_benchmarks(const std::string &filter) {
+    run(filter, "Lua error through handler", kOps / 10,
+        [](sel::State &state) {
+            state.HandleExceptionsWith([](int, std::string, std::exception_ptr) {});
+            state("function fail() error('fail') end");
+        },
+        [](sel::State &state, long n) {
+            for (long i = 0; i < n; ++i) state["fail"]();
+        });
+    run(filter, "C++ exception through Lua", kOps / 10,
+        [](sel::State &state) {
+            state.HandleExceptionsWith([](int, std::string, std::exception_ptr) {});
+            state["throw_fun"] = [] { throw std::runtime_error("fail"); };
+        },
+        [](sel::State &state, long n) {
+            for (long i = 0; i < n; ++i) state["throw_fun"]();
+        });
+}
+
+// A few of the above on a state with an Allocator, to show the cost of
+// its bookkeeping and the allocations Lua makes
+void allocator_benchmarks(const std::string &filter) {
+    run_with_allocator(filter, "[allocator] selector read depth 1", kOps,
+        [](sel::State &state) { state("a = 1"); },
+        [](sel::State &state, long n) {
+            int sink = 0;
+            for (long i = 0; i < n; ++i) sink += int(state["a"]);
+            if (sink == -1) std::cout << sink;
+        });
+    run_with_allocator(filter, "[allocator] Selector::Call", kOps,
+        [](sel::State &state) {
+            state("function add(a, b) return a + b end");
+        },
+        [](sel::State &state, long n) {
+            int sink = 0;
+            for (long i = 0; i < n; ++i) sink += state["add"].Call<int>(static_cast<int>(i), 1);
+            if (sink == -1) std::cout << sink;
+        });
+    run_with_allocator(filter, "[allocator] Lua->C++ string round trip", kOps,
+        [](sel::State &state) {
+            state["f"] = &echo;
+            state("s = string.rep('x', 64)");
+            state("function loop(n) for i = 1, n do f(s) end end");
+        }, lua_loop);
+}
+}
+
+// Runs all benchmarks, or only those whose name contains the first
+// command line argument.
+int main(int argc, char **argv) {
+    const std::string filter = argc > 1 ? argv[1] : "";
+    selector_benchmarks(filter);
+    lua_call_benchmarks(filter);
+    cpp_call_benchmarks(filter);
+    error_benchmarks(filter);
+    allocator_benchmarks(filter);
+    return 0;
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <selene.h>
+#include <string>
+
+// A very simple benchmarking framework
+// Each benchmark is a function that performs a given number of
+// operations. It is run a few times and the fastest run is reported
+// together with the number of heap allocations per operation. C++
+// allocations are always counted, allocations made by the Lua state
+// only when it uses a CountingAllocator.
+
+namespace bench {
+
+inline std::atomic<long long> &allocations() {
+    static std::atomic<long long> count{0};
+    return count;
+}
+
+// Allocator for the benchmarked states that counts every new block and
+// every block that grows. The State owns it, so the lua_State is closed
+// before anything registered through Selene is destroyed.
+class CountingAllocator : public sel::DefaultAllocator {
+public:
+    void *Allocate(std::size_t size) {
+        ++allocations();
+        return sel::DefaultAllocator::Allocate(size);
+    }
+
+    void *Reallocate(void *ptr, std::size_t old_size, std::size_t new_size) {
+        if (new_size > old_size) ++allocations();
+        return sel::DefaultAllocator::Reallocate(ptr, old_size, new_size);
+    }
+};
+
+struct Result {
+    double ns_per_op;
+    double allocs_per_op;
+};
+
+template <typename Fun>
+Result measure(long ops, Fun &&fun) {
+    // Warm up caches, interned strings and lazily created tables
+    fun(std::max(ops / 10, 1L));
+
+    Result best{1e300, 0};
+    for (int run = 0; run < 5; ++run) {
+        const long long allocs_before = allocations();
+        auto const start = std::chrono::steady_clock::now();
+        fun(ops);
+        std::chrono::duration<double, std::nano> const elapsed =
+            std::chrono::steady_clock::now() - start;
+        const double ns = elapsed.count() / ops;
+        if (ns < best.ns_per_op) {
+            best.ns_per_op = ns;
+            best.allocs_per_op =
+                double(allocations() - allocs_before) / ops;
+        }
+    }
+    return best;
+}
+
+template <typename Fun>
+void run(const std::string &filter, const char *name, long ops, Fun &&fun) {
+    if (!filter.empty() && std::string{name}.find(filter) == std::string::npos) {
+        return;
+    }
+    const Result result = measure(ops, fun);
+    std::printf("%-40s %12.1f ns/op %10.2f allocs/op\n",
+                name, result.ns_per_op, result.allocs_per_op);
+}
+}
@@ -5,4 +5,5 @@
 #endif
 
 #include "selene/State.h"
+#include "selene/StatePool.h"
 #include "selene/Tuple.h"
@@ -0,0 +1,387 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdlib>
+#include <vector>
+
+extern "C" {
+#include <lua.h>
+#include <lauxlib.h>
+}
+
+namespace sel {
+struct AllocatorStats {
+    std::size_t bytes_in_use = 0;
+    std::size_t peak_bytes = 0;
+    std::size_t allocations = 0;
+    std::size_t frees = 0;
+    // Allocations refused because of the hard limit
+    std::size_t refused = 0;
+};
+
+/*
+ * Memory policy for a State. Lua's realloc-style requests are split
+ * into Allocate, Reallocate and Free calls, and the bytes and blocks
+ * handed out are counted on the way.
+ */
+class Allocator {
+private:
+    AllocatorStats _stats;
+    std::size_t _soft_limit = 0;
+    std::size_t _hard_limit = 0;
+    bool _over_soft_limit = false;
+
+    int _protected_depth = 0;
+
+    void _update_soft_limit() {
+        _over_soft_limit = _soft_limit != 0 && _stats.bytes_in_use > _soft_limit;
+    }
+
+public:
+    virtual ~Allocator() {}
+
+    virtual void *Allocate(std::size_t size) = 0;
+    virtual void *Reallocate(void *ptr, std::size_t old_size, std::size_t new_size) = 0;
+    virtual void Free(void *ptr, std::size_t size) = 0;
+
+    const AllocatorStats &Stats() const {
+        return _stats;
+    }
+
+    /*
+     * Above the soft limit the state runs garbage collection steps,
+     * then a full collection, before each protected call into Lua.
+     * Above the hard limit allocations fail, and Lua raises a memory
+     * error that reaches the ExceptionHandler. The hard limit only
+     * applies while Lua runs inside a protected call, and not while a
+     * C++ function called from Lua runs: an error raised from C++ code
+     * would skip the destructors of its objects. 0 disables a limit.
+     */
+    void SetMemoryLimits(std::size_t soft_limit, std::size_t hard_limit) {
+        _soft_limit = soft_limit;
+        _hard_limit = hard_limit;
+        _update_soft_limit();
+    }
+
+    bool OverSoftLimit() const {
+        return _over_soft_limit;
+    }
+
+    // True if destroying the allocator frees every block it handed out,
+    // so that a state using it can be dropped without lua_close.
+    virtual bool CanReleaseAll() const {
+        return false;
+    }
+
+    // Number of protected calls into Lua in progress. It is reset to 0
+    // while Selene runs C++ code called from Lua, and restored after.
+    int ProtectedDepth() const {
+        return _protected_depth;
+    }
+
+    void SetProtectedDepth(int depth) {
+        _protected_depth = depth;
+    }
+
+    // lua_Alloc entry point, with the Allocator as its user data
+    static void *LuaAlloc(void *ud, void *ptr, std::size_t osize, std::size_t nsize) {
+        Allocator *self = static_cast<Allocator *>(ud);
+        AllocatorStats &stats = self->_stats;
+        // For new blocks osize holds the type of the object being created
+        if (ptr == nullptr) osize = 0;
+
+        if (nsize == 0) {
+            if (ptr != nullptr) {
+                self->Free(ptr, osize);
+                stats.bytes_in_use -= osize;
+                ++stats.frees;
+                self->_update_soft_limit();
+            }
+            return nullptr;
+        }
+
+        if (self->_hard_limit != 0 && self->_protected_depth > 0 && nsize > osize
+            && stats.bytes_in_use + (nsize - osize) > self->_hard_limit) {
+            ++stats.refused;
+            return nullptr;
+        }
+
+        void *result = ptr == nullptr
+            ? self->Allocate(nsize)
+            : self->Reallocate(ptr, osize, nsize);
+        if (result == nullptr) return nullptr;
+
+        if (ptr == nullptr) ++stats.allocations;
+        stats.bytes_in_use += nsize;
+        stats.bytes_in_use -= osize;
+        stats.peak_bytes = std::max(stats.peak_bytes, stats.bytes_in_use);
+        self->_update_soft_limit();
+        return result;
+    }
+};
+
+namespace detail {
+// The Allocator of a State created with one, nullptr otherwise
+inline Allocator *_get_allocator(lua_State *l) {
+    void *ud = nullptr;
+    if (lua_getallocf(l, &ud) != &Allocator::LuaAlloc) return nullptr;
+    return static_cast<Allocator *>(ud);
+}
+
+/*
+ * Scope of a protected call into Lua. Brings the state back under its
+ * soft limit first and enforces the hard limit while the call runs.
+ */
+class EnforceMemoryLimits {
+private:
+    Allocator *_allocator;
+    int _depth = 0;
+
+public:
+    explicit EnforceMemoryLimits(lua_State *l) : _allocator(_get_allocator(l)) {
+        if (_allocator == nullptr) return;
+        _depth = _allocator->ProtectedDepth();
+        for (int i = 0; i < 8 && _allocator->OverSoftLimit(); ++i) {
+            // Returns 1 once a collection cycle has finished
+            if (lua_gc(l, LUA_GCSTEP, 0)) break;
+        }
+        if (_allocator->OverSoftLimit()) {
+            lua_gc(l, LUA_GCCOLLECT, 0);
+        }
+        _allocator->SetProtectedDepth(_depth + 1);
+    }
+
+    // Restores the depth instead of decrementing it, which also repairs
+    // it after a Lua error skipped a SuspendMemoryLimits below
+    ~EnforceMemoryLimits() {
+        if (_allocator != nullptr) _allocator->SetProtectedDepth(_depth);
+    }
+
+    EnforceMemoryLimits(const EnforceMemoryLimits &) = delete;
+    EnforceMemoryLimits &operator=(const EnforceMemoryLimits &) = delete;
+};
+
+// Lifts the hard limit while C++ code called from Lua runs. Protected
+// calls made from that code enforce it again.
+class SuspendMemoryLimits {
+private:
+    Allocator *_allocator;
+    int _depth = 0;
+
+public:
+    explicit SuspendMemoryLimits(lua_State *l) : _allocator(_get_allocator(l)) {
+        if (_allocator == nullptr) return;
+        _depth = _allocator->ProtectedDepth();
+        _allocator->SetProtectedDepth(0);
+    }
+
+    ~SuspendMemoryLimits() {
+        if (_allocator != nullptr) _allocator->SetProtectedDepth(_depth);
+    }
+
+    SuspendMemoryLimits(const SuspendMemoryLimits &) = delete;
+    SuspendMemoryLimits &operator=(const SuspendMemoryLimits &) = delete;
+};
+
+inline int _pcall(lua_State *l, int nargs, int nresults, int msgh) {
+    EnforceMemoryLimits limits(l);
+    return lua_pcall(l, nargs, nresults, msgh);
+}
+
+// luaL_loadbufferx under the limits. Only the parser of lua_load runs
+// protected, so nothing else that allocates may be added to this scope.
+inline int _load_buffer(lua_State *l, const char *data, std::size_t size,
+                        const char *name, const char *mode) {
+    EnforceMemoryLimits limits(l);
+    return luaL_loadbufferx(l, data, size, name, mode);
+}
+}
+
+// Forwards to the C runtime, like the allocator of luaL_newstate
+class DefaultAllocator : public Allocator {
+public:
+    void *Allocate(std::size_t size) {
+        return std::malloc(size);
+    }
+
+    void *Reallocate(void *ptr, std::size_t, std::size_t new_size) {
+        return std::realloc(ptr, new_size);
+    }
+
+    void Free(void *ptr, std::size_t) {
+        std::free(ptr);
+    }
+};
+
+/*
+ * Serves the small blocks that make up most of Lua's allocations
+ * (strings, tables, closures, upvalues) from per-size-class free
+ * lists carved out of large chunks. Bigger blocks go to the C runtime
+ * and are kept in a list. Destroying the allocator releases all chunks
+ * and remaining big blocks at once, so it must outlive the lua_State
+ * using it.
+ */
+class PoolAllocator : public Allocator {
+private:
+    static constexpr std::size_t _granularity = 16;
+    static constexpr std::size_t _max_pooled_size = 256;
+    static constexpr std::size_t _num_classes = _max_pooled_size / _granularity;
+    static constexpr std::size_t _chunk_size = 64 * 1024;
+
+    struct FreeBlock {
+        FreeBlock *next;
+    };
+
+    // Header in front of every big block, padded to keep the block
+    // aligned like malloc's result
+    struct alignas(16) LargeBlock {
+        LargeBlock *prev;
+        LargeBlock *next;
+    };
+
+    std::array<FreeBlock *, _num_classes> _free_lists;
+    std::vector<void *> _chunks;
+    char *_chunk_cursor;
+    char *_chunk_end;
+    LargeBlock _large_blocks;
+
+    static bool _is_pooled(std::size_t size) {
+        return size <= _max_pooled_size;
+    }
+
+    static std::size_t _size_class(std::size_t size) {
+        return (size + _granularity - 1) / _granularity - 1;
+    }
+
+    void *_allocate_small(std::size_t size_class) {
+        FreeBlock *block = _free_lists[size_class];
+        if (block != nullptr) {
+            _free_lists[size_class] = block->next;
+            return block;
+        }
+        const std::size_t block_size = (size_class + 1) * _granularity;
+        if (static_cast<std::size_t>(_chunk_end - _chunk_cursor) < block_size) {
+            char *chunk = static_cast<char *>(std::malloc(_chunk_size));
+            if (chunk == nullptr) return nullptr;
+            _chunks.push_back(chunk);
+            _chunk_cursor = chunk;
+            _chunk_end = chunk + _chunk_size;
+        }
+        void *result = _chunk_cursor;
+        _chunk_cursor += block_size;
+        return result;
+    }
+
+    void _free_small(void *ptr, std::size_t size_class) {
+        FreeBlock *block = static_cast<FreeBlock *>(ptr);
+        block->next = _free_lists[size_class];
+        _free_lists[size_class] = block;
+    }
+
+    void _link(LargeBlock *block) {
+        block->prev = &_large_blocks;
+        block->next = _large_blocks.next;
+        _large_blocks.next->prev = block;
+        _large_blocks.next = block;
+    }
+
+    static void _unlink(LargeBlock *block) {
+        block->prev->next = block->next;
+        block->next->prev = block->prev;
+    }
+
+    static LargeBlock *_header(void *ptr) {
+        return static_cast<LargeBlock *>(ptr) - 1;
+    }
+
+    void *_allocate_large(std::size_t size) {
+        void *mem = std::malloc(sizeof(LargeBlock) + size);
+        if (mem == nullptr) return nullptr;
+        LargeBlock *block = static_cast<LargeBlock *>(mem);
+        _link(block);
+        return block + 1;
+    }
+
+    void *_reallocate_large(void *ptr, std::size_t new_size) {
+        LargeBlock *block = _header(ptr);
+        _unlink(block);
+        void *mem = std::realloc(block, sizeof(LargeBlock) + new_size);
+        if (mem == nullptr) {
+            _link(block);
+            return nullptr;
+        }
+        block = static_cast<LargeBlock *>(mem);
+        _link(block);
+        return block + 1;
+    }
+
+    void _free_large(void *ptr) {
+        LargeBlock *block = _header(ptr);
+        _unlink(block);
+        std::free(block);
+    }
+
+public:
+    PoolAllocator() : _chunk_cursor(nullptr), _chunk_end(nullptr) {
+        _free_lists.fill(nullptr);
+        _large_blocks.prev = &_large_blocks;
+        _large_blocks.next = &_large_blocks;
+    }
+
+    ~PoolAllocator() {
+        for (void *chunk : _chunks) {
+            std::free(chunk);
+        }
+        while (_large_blocks.next != &_large_blocks) {
+            LargeBlock *block = _large_blocks.next;
+            _unlink(block);
+            std::free(block);
+        }
+    }
+
+    bool CanReleaseAll() const {
+        return true;
+    }
+
+    PoolAllocator(const PoolAllocator &) = delete;
+    PoolAllocator &operator=(const PoolAllocator &) = delete;
+
+    void *Allocate(std::size_t size) {
+        if (_is_pooled(size)) {
+            return _allocate_small(_size_class(size));
+        }
+        return _allocate_large(size);
+    }
+
+    void *Reallocate(void *ptr, std::size_t old_size, std::size_t new_size) {
+        if (!_is_pooled(old_size) && !_is_pooled(new_size)) {
+            return _reallocate_large(ptr, new_size);
+        }
+        if (_is_pooled(old_size) && _is_pooled(new_size)
+            && _size_class(old_size) == _size_class(new_size)) {
+            return ptr;
+        }
+        void *result = Allocate(new_size);
+        if (result == nullptr) {
+            // Lua expects shrinking to succeed. The block is big enough
+            // to serve as one of the new size class from now on. A big
+            // block stays linked, so it is still released on destruction.
+            return new_size <= old_size ? ptr : nullptr;
+        }
+        std::copy_n(static_cast<char *>(ptr), std::min(old_size, new_size),
+                    static_cast<char *>(result));
+        Free(ptr, old_size);
+        return result;
+    }
+
+    void Free(void *ptr, std::size_t size) {
+        if (_is_pooled(size)) {
+            _free_small(ptr, _size_class(size));
+        } else {
+            _free_large(ptr);
+        }
+    }
+};
+}
@@ -0,0 +1,182 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+extern "C" {
+#include <lua.h>
+#include <lauxlib.h>
+}
+
+namespace sel {
+/*
+ * Borrowed view of contiguous numbers. Pushing a view gives Lua a small
+ * userdata that reads and writes the C++ elements through __index and
+ * __newindex, without copying them into a table. Views of const
+ * elements are read-only. The elements must outlive every use of the
+ * view in Lua.
+ */
+template <typename T>
+class ArrayView {
+public:
+    using value_type = typename std::remove_const<T>::type;
+
+private:
+    static_assert(std::is_arithmetic<value_type>::value &&
+                  !std::is_same<value_type, bool>::value,
+                  "ArrayView elements must be numbers");
+
+    T *_data;
+    std::size_t _size;
+
+public:
+    ArrayView() : _data(nullptr), _size(0) {}
+    ArrayView(T *data, std::size_t size) : _data(data), _size(size) {}
+
+    ArrayView(std::vector<value_type> &v) : ArrayView(v.data(), v.size()) {}
+    ArrayView(const std::vector<value_type> &v) : ArrayView(v.data(), v.size()) {}
+
+    template <std::size_t N>
+    ArrayView(std::array<value_type, N> &a) : ArrayView(a.data(), N) {}
+    template <std::size_t N>
+    ArrayView(const std::array<value_type, N> &a) : ArrayView(a.data(), N) {}
+
+    template <std::size_t N>
+    ArrayView(T (&a)[N]) : ArrayView(a, N) {}
+
+    T *data() const {
+        return _data;
+    }
+
+    std::size_t size() const {
+        return _size;
+    }
+
+    T *begin() const {
+        return _data;
+    }
+
+    T *end() const {
+        return _data + _size;
+    }
+
+    T &operator[](std::size_t i) const {
+        return _data[i];
+    }
+};
+
+namespace detail {
+template <typename T>
+inline void *_array_view_key() {
+    static char key;
+    return &key;
+}
+
+template <typename T>
+inline void _push_number(lua_State *l, T value, std::true_type /* integral */) {
+    lua_pushinteger(l, static_cast<lua_Integer>(value));
+}
+
+template <typename T>
+inline void _push_number(lua_State *l, T value, std::false_type) {
+    lua_pushnumber(l, static_cast<lua_Number>(value));
+}
+
+template <typename T>
+inline T _check_number(lua_State *l, int index, std::true_type /* integral */) {
+    return static_cast<T>(luaL_checkinteger(l, index));
+}
+
+template <typename T>
+inline T _check_number(lua_State *l, int index, std::false_type) {
+    return static_cast<T>(luaL_checknumber(l, index));
+}
+
+// The view at index, or nullptr if it is not an ArrayView<T>
+template <typename T>
+inline ArrayView<T> *_to_array_view(lua_State *l, int index) {
+    void *view = lua_touserdata(l, index);
+    if (view == nullptr || !lua_getmetatable(l, index)) return nullptr;
+    lua_rawgetp(l, LUA_REGISTRYINDEX, _array_view_key<T>());
+    const bool same = lua_rawequal(l, -1, -2) != 0;
+    lua_pop(l, 2);
+    return same ? static_cast<ArrayView<T> *>(view) : nullptr;
+}
+
+// Position of the element for the key at index, or 0 if out of range
+template <typename T>
+inline std::size_t _array_view_position(lua_State *l, const ArrayView<T> &view, int index) {
+    int is_num = 0;
+    const lua_Integer i = lua_tointegerx(l, index, &is_num);
+    if (!is_num || i < 1 || static_cast<std::size_t>(i) > view.size()) return 0;
+    return static_cast<std::size_t>(i);
+}
+
+template <typename T>
+inline int _array_view_index(lua_State *l) {
+    ArrayView<T> *view = _to_array_view<T>(l, 1);
+    luaL_argcheck(l, view != nullptr, 1, "array view expected");
+    const std::size_t i = _array_view_position(l, *view, 2);
+    if (i == 0) {
+        lua_pushnil(l);
+    } else {
+        using V = typename ArrayView<T>::value_type;
+        _push_number<V>(l, (*view)[i - 1], std::is_integral<V>{});
+    }
+    return 1;
+}
+
+template <typename T>
+inline void _array_view_store(lua_State *l, const ArrayView<T> &, std::size_t,
+                              std::true_type /* const */) {
+    luaL_error(l, "array view is read-only");
+}
+
+template <typename T>
+inline void _array_view_store(lua_State *l, const ArrayView<T> &view, std::size_t i,
+                              std::false_type) {
+    view[i - 1] = _check_number<T>(l, 3, std::is_integral<T>{});
+}
+
+template <typename T>
+inline int _array_view_newindex(lua_State *l) {
+    ArrayView<T> *view = _to_array_view<T>(l, 1);
+    luaL_argcheck(l, view != nullptr, 1, "array view expected");
+    const std::size_t i = _array_view_position(l, *view, 2);
+    luaL_argcheck(l, i != 0, 2, "index out of range");
+    _array_view_store(l, *view, i, std::is_const<T>{});
+    return 0;
+}
+
+template <typename T>
+inline int _array_view_len(lua_State *l) {
+    ArrayView<T> *view = _to_array_view<T>(l, 1);
+    luaL_argcheck(l, view != nullptr, 1, "array view expected");
+    lua_pushinteger(l, static_cast<lua_Integer>(view->size()));
+    return 1;
+}
+
+template <typename T>
+inline void _push_array_view(lua_State *l, ArrayView<T> view) {
+    void *addr = lua_newuserdata(l, sizeof(ArrayView<T>));
+    new(addr) ArrayView<T>(view);
+    lua_rawgetp(l, LUA_REGISTRYINDEX, _array_view_key<T>());
+    if (lua_isnil(l, -1)) {
+        lua_pop(l, 1);
+        lua_createtable(l, 0, 3);
+        lua_pushcfunction(l, &_array_view_index<T>);
+        lua_setfield(l, -2, "__index");
+        lua_pushcfunction(l, &_array_view_newindex<T>);
+        lua_setfield(l, -2, "__newindex");
+        lua_pushcfunction(l, &_array_view_len<T>);
+        lua_setfield(l, -2, "__len");
+        lua_pushvalue(l, -1);
+        lua_rawsetp(l, LUA_REGISTRYINDEX, _array_view_key<T>());
+    }
+    lua_setmetatable(l, -2);
+}
+}
+}
@@ -1,10 +1,12 @@
 #pragma once
 
+#include "Allocator.h"
 #include "function.h"
 #include <exception>
 #include "ExceptionHandler.h"
 #include <functional>
 #include "primitives.h"
+#include <string>
 #include <tuple>
 #include "util.h"
 
@@ -16,28 +18,34 @@ struct BaseFun {
 
 namespace detail {
 
-inline int _lua_dispatcher(lua_State *l) {
-    BaseFun *fun = (BaseFun *)lua_touserdata(l, lua_upvalueindex(1));
+// Runs apply(l) and turns C++ exceptions escaping from it into Lua
+// errors once no C++ objects are left on the way to lua_error.
+template <typename Apply>
+inline int _dispatch(lua_State *l, Apply apply) {
     _lua_check_get raiseParameterConversionError = nullptr;
     const char * wrong_meta_table = nullptr;
     int erroneousParameterIndex = 0;
-    try {
-        return fun->Apply(l);
-    } catch (GetParameterFromLuaTypeError & e) {
-        raiseParameterConversionError = e.checked_get;
-        erroneousParameterIndex = e.index;
-    } catch (GetUserdataParameterFromLuaTypeError & e) {
-        wrong_meta_table = lua_pushlstring(
-            l, e.metatable_name.c_str(), e.metatable_name.length());
-        erroneousParameterIndex = e.index;
-    } catch (std::exception & e) {
-        lua_pushstring(l, e.what());
-        Traceback(l);
-        store_current_exception(l, lua_tostring(l, -1));
-    } catch (...) {
-        lua_pushliteral(l, "<Unknown exception>");
-        Traceback(l);
-        store_current_exception(l, lua_tostring(l, -1));
+    {
+        // No allocation may fail while C++ objects are alive
+        SuspendMemoryLimits suspend(l);
+        try {
+            return apply(l);
+        } catch (GetParameterFromLuaTypeError & e) {
+            raiseParameterConversionError = e.checked_get;
+            erroneousParameterIndex = e.index;
+        } catch (GetUserdataParameterFromLuaTypeError & e) {
+            wrong_meta_table = lua_pushlstring(
+                l, e.metatable_name.c_str(), e.metatable_name.length());
+            erroneousParameterIndex = e.index;
+        } catch (std::exception & e) {
+            lua_pushstring(l, e.what());
+            Traceback(l);
+            store_current_exception(l, lua_tostring(l, -1));
+        } catch (...) {
+            lua_pushliteral(l, "<Unknown exception>");
+            Traceback(l);
+            store_current_exception(l, lua_tostring(l, -1));
+        }
     }
 
     if(raiseParameterConversionError) {
@@ -50,6 +58,13 @@ inline int _lua_dispatcher(lua_State *l) {
     return lua_error(l);
 }
 
+inline int _lua_dispatcher(lua_State *l) {
+    BaseFun *fun = (BaseFun *)lua_touserdata(l, lua_upvalueindex(1));
+    return _dispatch(l, [fun](lua_State *state) {
+        return fun->Apply(state);
+    });
+}
+
 template <typename Ret, typename... Args, std::size_t... N>
 inline Ret _lift(std::function<Ret(Args...)> fun,
                  std::tuple<Args...> args,
@@ -65,14 +80,29 @@ inline Ret _lift(std::function<Ret(Args...)> fun,
 
 
 template <typename... T, std::size_t... N>
-inline std::tuple<T...> _get_args(lua_State *state, _indices<N...>) {
-    return std::tuple<T...>{_check_get(_id<T>{}, state, N + 1)...};
+inline std::tuple<T...> _get_args(lua_State *state, int first, _indices<N...>) {
+    return std::tuple<T...>{_check_get(_id<T>{}, state, N + first)...};
 }
 
+// Reads the arguments starting at stack index first
 template <typename... T>
-inline std::tuple<T...> _get_args(lua_State *state) {
+inline std::tuple<T...> _get_args(lua_State *state, int first = 1) {
     constexpr std::size_t num_args = sizeof...(T);
-    return _get_args<T...>(state, typename _indices_builder<num_args>::type());
+    return _get_args<T...>(state, first, typename _indices_builder<num_args>::type());
+}
+
+// Returns the receiver of a method call at stack index 1 after checking
+// the type tag of its metatable.
+template <typename T>
+inline T *_get_self(lua_State *state, const std::string &metatable_name) {
+    T *self = nullptr;
+    if(MetatableRegistry::IsType(state, typeid(T), 1)) {
+        self = (T *)lua_touserdata(state, 1);
+    }
+    if(self == nullptr) {
+        throw GetUserdataParameterFromLuaTypeError{metatable_name, 1};
+    }
+    return self;
 }
 }
 }
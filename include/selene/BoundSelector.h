@@ -0,0 +1,102 @@
+#pragma once
+
+#include "LuaRef.h"
+#include "primitives.h"
+#include "ResourceHandler.h"
+#include "Selector.h"
+#include <utility>
+
+namespace sel {
+/*
+ * A Selector whose parent table has been resolved once and pinned in
+ * the registry. Reads and writes push the pinned table and perform a
+ * single lookup of the leaf key instead of walking the whole path
+ * from the global table. If the parent table is replaced from Lua,
+ * call Invalidate() and the path will be resolved again on the next
+ * access.
+ */
+class BoundSelector {
+private:
+    Selector _selector;
+
+    // Registry reference to the resolved parent table.
+    mutable LuaRef _parent;
+    mutable bool _resolved;
+
+    void _resolve() const {
+        if (_resolved) return;
+        lua_State *l = _selector._state;
+        _selector._traverse();
+        _parent = LuaRef(l, luaL_ref(l, LUA_REGISTRYINDEX));
+        _resolved = true;
+    }
+
+    // Pushes the value stored under the leaf key to the stack
+    void _push_leaf() const {
+        _resolve();
+        _parent.Push(_selector._state);
+        _selector._get();
+    }
+
+public:
+    explicit BoundSelector(const Selector &selector)
+        : _selector(selector), _parent(selector._state), _resolved(false) {
+        // A bound path is only ever read or written, never invoked
+        _selector._functor_active = false;
+        ResetStackOnScopeExit save(_selector._state);
+        _resolve();
+    }
+
+    BoundSelector(const BoundSelector &other)
+        : _selector(other._selector), _parent(other._parent.Copy()),
+          _resolved(other._resolved) {}
+
+    BoundSelector(BoundSelector &&) = default;
+
+    // Drops the pinned parent table. The next access walks the path
+    // again, picking up a table that has been replaced in the meantime.
+    void Invalidate() {
+        _resolved = false;
+        _parent = LuaRef(_selector._state);
+    }
+
+    // The value is popped before it is returned, so like the results of
+    // calls it cannot be read as a view of a Lua string
+    template <typename T>
+    T Get() const {
+        static_assert(!detail::_is_string_view<T>::value,
+                      "Results cannot be string views; use std::string");
+        ResetStackOnScopeExit save(_selector._state);
+        _push_leaf();
+        return detail::_pop(detail::_id<T>{}, _selector._state);
+    }
+
+    template <typename T>
+    void Set(T &&value) const {
+        lua_State *l = _selector._state;
+        ResetStackOnScopeExit save(l);
+        _resolve();
+        _parent.Push(l);
+        if (!lua_istable(l, -1)) {
+            // The path did not exist when it was resolved
+            lua_pop(l, 1);
+            _selector._traverse(true);
+            lua_pushvalue(l, -1);
+            _parent = LuaRef(l, luaL_ref(l, LUA_REGISTRYINDEX));
+        }
+        _selector._put([l, &value]() {
+            detail::_push(l, std::forward<T>(value));
+        });
+    }
+
+    bool exists() const {
+        ResetStackOnScopeExit save(_selector._state);
+        _push_leaf();
+        return !lua_isnil(_selector._state, -1);
+    }
+};
+
+inline BoundSelector Selector::Bind() const {
+    return BoundSelector{*this};
+}
+}
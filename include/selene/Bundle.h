@@ -0,0 +1,211 @@
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include "MappedFile.h"
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+extern "C" {
+#include <lua.h>
+#include <lauxlib.h>
+}
+
+namespace sel {
+/*
+ * A bundle is a single file holding many precompiled chunks, looked up
+ * by module name. All integers are little endian:
+ *
+ *     "SELBNDL1"  magic
+ *     u32         number of entries
+ *     per entry:  u32 name length, name, u64 offset, u64 length
+ *     chunks      offsets are relative to the start of the file
+ */
+namespace detail {
+inline const char *_bundle_magic() {
+    return "SELBNDL1";
+}
+
+inline void _put_le(std::string &out, std::uint64_t value, int bytes) {
+    for (int i = 0; i < bytes; ++i) {
+        out.push_back(static_cast<char>((value >> (8 * i)) & 0xff));
+    }
+}
+
+inline bool _get_le(const char *&data, const char *end, int bytes,
+                    std::uint64_t &value) {
+    if (end - data < bytes) return false;
+    value = 0;
+    for (int i = 0; i < bytes; ++i) {
+        value |= static_cast<std::uint64_t>(static_cast<unsigned char>(data[i])) << (8 * i);
+    }
+    data += bytes;
+    return true;
+}
+}
+
+class BundleWriter {
+private:
+    std::vector<std::pair<std::string, std::string>> _chunks;
+
+public:
+    void Add(std::string module, std::string chunk) {
+        _chunks.emplace_back(std::move(module), std::move(chunk));
+    }
+
+    bool Write(const std::string &path) const {
+        std::string index{detail::_bundle_magic()};
+        detail::_put_le(index, _chunks.size(), 4);
+        std::size_t index_size = index.size();
+        for (const auto &chunk : _chunks) {
+            index_size += 4 + chunk.first.size() + 16;
+        }
+        std::uint64_t offset = index_size;
+        for (const auto &chunk : _chunks) {
+            detail::_put_le(index, chunk.first.size(), 4);
+            index += chunk.first;
+            detail::_put_le(index, offset, 8);
+            detail::_put_le(index, chunk.second.size(), 8);
+            offset += chunk.second.size();
+        }
+
+        std::ofstream out(path, std::ios::out | std::ios::binary | std::ios::trunc);
+        out.write(index.data(), index.size());
+        for (const auto &chunk : _chunks) {
+            out.write(chunk.second.data(), chunk.second.size());
+        }
+        return static_cast<bool>(out);
+    }
+};
+
+/*
+ * Read-only view of a bundle file. The file stays mapped for the
+ * lifetime of the object and chunks are loaded straight from it.
+ */
+class Bundle {
+private:
+    struct Chunk {
+        std::size_t offset;
+        std::size_t length;
+    };
+
+    std::string _path;
+    MappedFile _file;
+    std::unordered_map<std::string, Chunk> _index;
+    bool _valid = false;
+
+    bool _parse() {
+        const char *data = _file.Data();
+        const char *end = data + _file.Size();
+        const std::size_t magic_size = std::char_traits<char>::length(detail::_bundle_magic());
+        if (_file.Size() < magic_size ||
+            std::char_traits<char>::compare(data, detail::_bundle_magic(), magic_size) != 0) {
+            return false;
+        }
+        data += magic_size;
+        std::uint64_t count;
+        if (!detail::_get_le(data, end, 4, count)) return false;
+        for (std::uint64_t i = 0; i < count; ++i) {
+            std::uint64_t name_size, offset, length;
+            if (!detail::_get_le(data, end, 4, name_size)) return false;
+            if (static_cast<std::uint64_t>(end - data) < name_size) return false;
+            std::string name(data, static_cast<std::size_t>(name_size));
+            data += name_size;
+            if (!detail::_get_le(data, end, 8, offset) ||
+                !detail::_get_le(data, end, 8, length)) {
+                return false;
+            }
+            if (offset > _file.Size() || length > _file.Size() - offset) {
+                return false;
+            }
+            _index[std::move(name)] = Chunk{static_cast<std::size_t>(offset),
+                                            static_cast<std::size_t>(length)};
+        }
+        return true;
+    }
+
+public:
+    explicit Bundle(const std::string &path) : _path(path), _file(path) {
+        _valid = _file.Valid() && _parse();
+    }
+
+    Bundle(const Bundle &) = delete;
+    Bundle &operator=(const Bundle &) = delete;
+
+    // False if the file is missing or not a well-formed bundle
+    bool Valid() const {
+        return _valid;
+    }
+
+    const std::string &Path() const {
+        return _path;
+    }
+
+    std::size_t Size() const {
+        return _index.size();
+    }
+
+    bool Contains(const std::string &module) const {
+        return _index.count(module) != 0;
+    }
+
+    // Pushes the chunk of the module like luaL_loadbuffer. Returns
+    // LUA_ERRFILE without pushing anything if the module is not found.
+    int Load(lua_State *l, const std::string &module) const {
+        auto it = _index.find(module);
+        if (it == _index.end()) return LUA_ERRFILE;
+        const std::string chunk_name = "@" + module;
+        return luaL_loadbuffer(l, _file.Data() + it->second.offset,
+                               it->second.length, chunk_name.c_str());
+    }
+};
+
+namespace detail {
+// Entry of package.searchers. Upvalue 1 is the Bundle. No C++ object
+// with a destructor may be alive when a Lua error is raised here.
+inline int _bundle_searcher(lua_State *l) {
+    const Bundle *bundle = static_cast<const Bundle *>(
+        lua_touserdata(l, lua_upvalueindex(1)));
+    const char *module = luaL_checkstring(l, 1);
+    const int status = bundle->Load(l, module);
+    if (status == LUA_ERRFILE) {
+        lua_pushfstring(l, "\n\tno module '%s' in bundle '%s'",
+                        module, bundle->Path().c_str());
+        return 1;
+    }
+    if (status != 0) {
+        return luaL_error(l, "error loading module '%s' from bundle '%s':\n\t%s",
+                          module, bundle->Path().c_str(), lua_tostring(l, -1));
+    }
+    lua_pushstring(l, bundle->Path().c_str());
+    return 2;
+}
+
+// Inserts a searcher for the bundle right after the preload searcher,
+// so bundled modules win over files on package.path
+inline bool _add_bundle_searcher(lua_State *l, const Bundle *bundle) {
+    lua_getglobal(l, "package");
+    if (!lua_istable(l, -1)) {
+        lua_pop(l, 1);
+        return false;
+    }
+    lua_getfield(l, -1, "searchers");
+    if (!lua_istable(l, -1)) {
+        lua_pop(l, 2);
+        return false;
+    }
+    const int searchers = lua_gettop(l);
+    for (int i = static_cast<int>(lua_rawlen(l, searchers)); i >= 2; --i) {
+        lua_rawgeti(l, searchers, i);
+        lua_rawseti(l, searchers, i + 1);
+    }
+    lua_pushlightuserdata(l, const_cast<Bundle *>(bundle));
+    lua_pushcclosure(l, &_bundle_searcher, 1);
+    lua_rawseti(l, searchers, 2);
+    lua_pop(l, 2);
+    return true;
+}
+}
+}
@@ -0,0 +1,134 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+extern "C" {
+#include <lua.h>
+#include <lauxlib.h>
+}
+
+namespace sel {
+namespace detail {
+
+inline int _string_writer(lua_State *, const void *p, size_t size, void *ud) {
+    static_cast<std::string *>(ud)->append(static_cast<const char *>(p), size);
+    return 0;
+}
+
+// Bytecode of the function on top of the stack. Debug information, such
+// as line numbers for error messages, is stripped when strip is set and
+// the Lua version supports it.
+inline std::string _dump_function(lua_State *l, bool strip) {
+    std::string bytecode;
+#if LUA_VERSION_NUM >= 503
+    lua_dump(l, &_string_writer, &bytecode, strip ? 1 : 0);
+#else
+    (void)strip;
+    lua_dump(l, &_string_writer, &bytecode);
+#endif
+    return bytecode;
+}
+
+inline bool _read_file(const std::string &path, std::string &contents) {
+    std::ifstream in(path, std::ios::in | std::ios::binary);
+    if (!in) return false;
+    contents.assign(std::istreambuf_iterator<char>(in),
+                    std::istreambuf_iterator<char>());
+    return !in.bad();
+}
+
+// Offset of the Lua code in a script file, skipping a UTF-8 byte order
+// mark and a first line starting with '#' like luaL_loadfile does. The
+// newline is kept so that line numbers stay the same, unless bytecode
+// follows.
+inline std::size_t _source_start(const char *data, std::size_t size) {
+    std::size_t start = 0;
+    if (size >= 3 && std::memcmp(data, "\xEF\xBB\xBF", 3) == 0) start = 3;
+    if (start < size && data[start] == '#') {
+        while (start < size && data[start] != '\n') ++start;
+        if (start + 1 < size && data[start + 1] == LUA_SIGNATURE[0]) ++start;
+    }
+    return start;
+}
+
+inline std::size_t _source_start(const std::string &source) {
+    return _source_start(source.data(), source.size());
+}
+
+inline std::uint64_t _fnv1a(const char *data, std::size_t size,
+                            std::uint64_t hash = 14695981039346656037ull) {
+    for (std::size_t i = 0; i < size; ++i) {
+        hash ^= static_cast<unsigned char>(data[i]);
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+inline std::uint64_t _fnv1a(const std::string &data,
+                            std::uint64_t hash = 14695981039346656037ull) {
+    return _fnv1a(data.data(), data.size(), hash);
+}
+}
+
+/*
+ * Directory of compiled chunks. An entry is keyed by a hash of the
+ * script path, its contents and the Lua version, so an edited script
+ * or a different interpreter never picks up stale bytecode. Entries
+ * are written to a temporary file and renamed into place, so a reader
+ * never sees a partial entry.
+ */
+class BytecodeCache {
+private:
+    std::string _directory;
+
+public:
+    BytecodeCache() = default;
+    explicit BytecodeCache(std::string directory)
+        : _directory(std::move(directory)) {}
+
+    bool Enabled() const {
+        return !_directory.empty();
+    }
+
+    std::string EntryPath(const std::string &file, const char *source,
+                          std::size_t size) const {
+        std::uint64_t hash = detail::_fnv1a(file);
+        hash = detail::_fnv1a(source, size, hash);
+        hash = detail::_fnv1a(std::to_string(LUA_VERSION_NUM), hash);
+        char name[32];
+        std::snprintf(name, sizeof(name), "%016llx.luac",
+                      static_cast<unsigned long long>(hash));
+        return _directory + "/" + name;
+    }
+
+    std::string EntryPath(const std::string &file, const std::string &source) const {
+        return EntryPath(file, source.data(), source.size());
+    }
+
+    bool Read(const std::string &entry, std::string &bytecode) const {
+        return detail::_read_file(entry, bytecode);
+    }
+
+    void Write(const std::string &entry, const std::string &bytecode) const {
+        const std::string temp = entry + ".tmp";
+        {
+            std::ofstream out(temp, std::ios::out | std::ios::binary | std::ios::trunc);
+            if (!out) return;
+            out.write(bytecode.data(), bytecode.size());
+            if (!out) {
+                out.close();
+                std::remove(temp.c_str());
+                return;
+            }
+        }
+        if (std::rename(temp.c_str(), entry.c_str()) != 0) {
+            std::remove(temp.c_str());
+        }
+    }
+};
+}
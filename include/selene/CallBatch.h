@@ -0,0 +1,52 @@
+#pragma once
+
+#include "ExceptionHandler.h"
+#include "util.h"
+
+extern "C" {
+#include <lua.h>
+}
+
+namespace sel {
+/*
+ * Pins Selene's message handler on the Lua stack for the lifetime of
+ * the object. Calls made through Selectors and sel::functions of the
+ * same State in the meantime reuse it instead of pushing a handler of
+ * their own for every call.
+ */
+class CallBatch {
+private:
+    lua_State *_state;
+    ExceptionHandler *_exception_handler;
+    int _index;
+    int _previous_index;
+
+public:
+    CallBatch(lua_State *l, ExceptionHandler &eh)
+        : _state(l), _exception_handler(&eh),
+          _index(SetErrorHandler(l)),
+          _previous_index(eh.MessageHandlerIndex()) {
+        eh.SetMessageHandlerIndex(_index);
+    }
+
+    CallBatch(const CallBatch &) = delete;
+    CallBatch & operator=(const CallBatch &) = delete;
+
+    CallBatch(CallBatch &&other)
+        : _state(other._state), _exception_handler(other._exception_handler),
+          _index(other._index), _previous_index(other._previous_index) {
+        other._state = nullptr;
+    }
+
+    CallBatch & operator=(CallBatch &&) = delete;
+
+    ~CallBatch() {
+        if (_state == nullptr) return;
+        _exception_handler->SetMessageHandlerIndex(_previous_index);
+        if (_index <= lua_gettop(_state) &&
+            lua_tocfunction(_state, _index) == &ErrorHandler) {
+            lua_remove(_state, _index);
+        }
+    }
+};
+}
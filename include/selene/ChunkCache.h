@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstddef>
+#include <list>
+#include "LuaRef.h"
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+extern "C" {
+#include <lua.h>
+#include <lauxlib.h>
+}
+
+namespace sel {
+struct ChunkCacheStats {
+    std::size_t hits = 0;
+    std::size_t misses = 0;
+    std::size_t evictions = 0;
+};
+
+/*
+ * Least recently used cache of compiled code snippets, keyed by their
+ * source text or an id chosen by the caller. The compiled functions are
+ * held as registry references, so the cache must be cleared before its
+ * lua_State is closed.
+ */
+class ChunkCache {
+private:
+    struct Entry {
+        std::string code;
+        LuaRef function;
+    };
+    using Entries = std::list<Entry>;
+
+    std::size_t _capacity = 0;
+    Entries _entries;
+    std::unordered_map<std::string, Entries::iterator> _index;
+    ChunkCacheStats _stats;
+
+    void _evict_to(std::size_t size) {
+        while (_entries.size() > size) {
+            _index.erase(_entries.back().code);
+            _entries.pop_back();
+            ++_stats.evictions;
+        }
+    }
+
+public:
+    bool Enabled() const {
+        return _capacity != 0;
+    }
+
+    std::size_t Capacity() const {
+        return _capacity;
+    }
+
+    // 0 disables the cache and drops all entries
+    void SetCapacity(std::size_t capacity) {
+        _capacity = capacity;
+        _evict_to(capacity);
+    }
+
+    void Clear() {
+        _index.clear();
+        _entries.clear();
+    }
+
+    const ChunkCacheStats &Stats() const {
+        return _stats;
+    }
+
+    // Pushes the function cached for key and returns true, or returns
+    // false and pushes nothing
+    bool Push(lua_State *l, const std::string &key) {
+        auto it = _index.find(key);
+        if (it == _index.end()) {
+            ++_stats.misses;
+            return false;
+        }
+        ++_stats.hits;
+        _entries.splice(_entries.begin(), _entries, it->second);
+        it->second->function.Push(l);
+        return true;
+    }
+
+    // Caches the function on top of the stack under key, leaving it on
+    // the stack. Call it outside of the memory limits, since luaL_ref
+    // runs unprotected.
+    void Insert(lua_State *l, const std::string &key) {
+        lua_pushvalue(l, -1);
+        _entries.push_front(Entry{key, LuaRef(l, luaL_ref(l, LUA_REGISTRYINDEX))});
+        _index.emplace(key, _entries.begin());
+        _evict_to(_capacity);
+    }
+};
+}
@@ -6,6 +6,8 @@
 #include "MetatableRegistry.h"
 #include <map>
 #include <memory>
+#include "Property.h"
+#include "StaticFun.h"
 #include "util.h"
 #include <vector>
 #include <stack>
@@ -28,6 +30,8 @@ private:
     std::unique_ptr<Dtor<T>> _dtor;
     using Funs = std::vector<std::unique_ptr<BaseFun>>;
     Funs _funs;
+    using Properties = std::vector<std::pair<std::string, std::unique_ptr<BaseProperty>>>;
+    Properties _properties;
 
     void _register_ctor(lua_State *state) {
         _ctor.reset(new A(state, _metatable_name.c_str()));
@@ -124,6 +128,44 @@ private:
                 _metatable_name.c_str(), lambda));
     }
 
+    template <typename F, F f>
+    void _register_member(lua_State *state,
+                          const char *fun_name,
+                          StaticFun<F, f>) {
+        lua_pushcfunction(state, (&detail::_static_fun<F, f>::call));
+        lua_setfield(state, -2, fun_name);
+    }
+
+    template <typename M>
+    void _register_member(lua_State *,
+                          const char *member_name,
+                          PropertyMember<T, M> property) {
+        _properties.emplace_back(
+            std::string{member_name},
+            sel::make_unique<Property<T, M>>(property.member, _metatable_name));
+    }
+
+    // Installs __index and __newindex closures that resolve property
+    // names to their field accessors before falling back to methods.
+    void _register_properties(lua_State *state) {
+        if (_properties.empty()) {
+            lua_pushvalue(state, -1);
+            lua_setfield(state, -1, "__index");
+            return;
+        }
+        lua_createtable(state, 0, _properties.size());
+        for (auto &property : _properties) {
+            lua_pushlightuserdata(state, property.second.get());
+            lua_setfield(state, -2, property.first.c_str());
+        }
+        lua_pushvalue(state, -1);
+        lua_pushvalue(state, -3);
+        lua_pushcclosure(state, &detail::_property_index, 2);
+        lua_setfield(state, -3, "__index");
+        lua_pushcclosure(state, &detail::_property_newindex, 1);
+        lua_setfield(state, -2, "__newindex");
+    }
+
     void _register_members(lua_State *state) {}
 
     template <typename M, typename... Ms>
@@ -144,8 +186,7 @@ public:
         _register_dtor(state);
         _register_ctor(state);
         _register_members(state, members...);
-        lua_pushvalue(state, -1);
-        lua_setfield(state, -1, "__index");
+        _register_properties(state);
     }
     ~Class() = default;
     Class(const Class &) = delete;
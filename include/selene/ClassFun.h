@@ -13,12 +13,6 @@ private:
     std::string _name;
     std::string _metatable_name;
 
-    T *_get(lua_State *state) {
-        T *ret = (T *)luaL_checkudata(state, 1, _metatable_name.c_str());
-        lua_remove(state, 1);
-        return ret;
-    }
-
 public:
     ClassFun(lua_State *l,
              const std::string &name,
@@ -37,8 +31,9 @@ public:
     }
 
     int Apply(lua_State *l) {
-        std::tuple<T*> t = std::make_tuple(_get(l));
-        std::tuple<Args...> args = detail::_get_args<Args...>(l);
+        std::tuple<T*> t = std::make_tuple(
+            detail::_get_self<T>(l, _metatable_name));
+        std::tuple<Args...> args = detail::_get_args<Args...>(l, 2);
         std::tuple<T*, Args...> pack = std::tuple_cat(t, args);
         detail::_push(l, detail::_lift(_fun, pack));
         return N;
@@ -53,12 +48,6 @@ private:
     std::string _name;
     std::string _metatable_name;
 
-    T *_get(lua_State *state) {
-        T *ret = (T *)luaL_checkudata(state, 1, _metatable_name.c_str());
-        lua_remove(state, 1);
-        return ret;
-    }
-
 public:
     ClassFun(lua_State *l,
              const std::string &name,
@@ -77,8 +66,9 @@ public:
     }
 
     int Apply(lua_State *l) {
-        std::tuple<T*> t = std::make_tuple(_get(l));
-        std::tuple<Args...> args = detail::_get_args<Args...>(l);
+        std::tuple<T*> t = std::make_tuple(
+            detail::_get_self<T>(l, _metatable_name));
+        std::tuple<Args...> args = detail::_get_args<Args...>(l, 2);
         std::tuple<T*, Args...> pack = std::tuple_cat(t, args);
         detail::_lift(_fun, pack);
         return 0;
@@ -17,6 +17,7 @@ public:
              void *addr = lua_newuserdata(state, sizeof(T));
              new(addr) T(args...);
              luaL_setmetatable(state, metatable_name.c_str());
+             detail::_track_owned_userdata(state);
            }) {
         lua_pushlightuserdata(l, (void *)static_cast<BaseFun *>(this));
         lua_pushcclosure(l, &detail::_lua_dispatcher, 1);
@@ -18,8 +18,9 @@ public:
     }
 
     int Apply(lua_State *l) {
-        T *t = (T *)luaL_checkudata(l, 1, _metatable_name.c_str());
+        T *t = detail::_get_self<T>(l, _metatable_name);
         t->~T();
+        detail::_mark_finalized(l, 1);
         return 0;
     }
 };
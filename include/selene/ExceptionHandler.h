@@ -23,6 +23,7 @@ inline std::string const * _stored_exception_metatable_name() {
 inline int _delete_stored_exception(lua_State * l) {
     void * user_data = lua_touserdata(l, -1);
     static_cast<stored_exception *>(user_data)->~stored_exception();
+    detail::_mark_finalized(l, 1);
     return 0;
 }
 
@@ -52,6 +53,7 @@ inline void store_current_exception(lua_State * l, char const * what) {
     }
 
     lua_setmetatable(l, -2);
+    detail::_track_owned_userdata(l);
 }
 
 inline stored_exception * test_stored_exception(lua_State *l) {
@@ -88,11 +90,32 @@ public:
 private:
     function _handler;
 
+    // Stack index of a message handler pinned by a CallBatch, 0 if none
+    int _message_handler_index = 0;
+
 public:
     ExceptionHandler() = default;
 
     explicit ExceptionHandler(function && handler) : _handler(handler) {}
 
+    const function &Handler() const {
+        return _handler;
+    }
+
+    // Replaces the callback only, keeping a message handler pinned by a
+    // CallBatch that is still alive
+    void SetHandler(function handler) {
+        _handler = std::move(handler);
+    }
+
+    int MessageHandlerIndex() const {
+        return _message_handler_index;
+    }
+
+    void SetMessageHandlerIndex(int index) {
+        _message_handler_index = index;
+    }
+
     void Handle(int luaStatusCode, std::string message, std::exception_ptr exception = nullptr) {
         if(_handler) {
             _handler(luaStatusCode, std::move(message), std::move(exception));
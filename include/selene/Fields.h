@@ -0,0 +1,36 @@
+#pragma once
+
+#include <tuple>
+#include "traits.h"
+#include <type_traits>
+
+/*
+ * Describes the fields of a plain struct so that it is converted to and
+ * from a Lua table by value, like the member lists passed to SetClass:
+ *
+ *     struct Event { int id; std::string name; };
+ *     SEL_FIELDS(Event, "id", &Event::id, "name", &Event::name)
+ *
+ * Use it in the namespace of the struct. Fields can be of any type
+ * Selene converts, including containers and other described structs.
+ */
+#define SEL_FIELDS(Type, ...)                                            \
+    inline auto selene_fields(::sel::detail::_id<Type>)                  \
+        -> decltype(std::make_tuple(__VA_ARGS__)) {                      \
+        return std::make_tuple(__VA_ARGS__);                             \
+    }
+
+namespace sel {
+namespace detail {
+// selene_fields is found through argument dependent lookup, in the
+// namespace of T where SEL_FIELDS was used
+template <typename T, typename = void>
+struct _has_fields : std::false_type {};
+
+template <typename T>
+struct _has_fields<T, decltype(void(selene_fields(_id<T>{})))> : std::true_type {};
+
+template <typename T>
+using _fields_type = decltype(selene_fields(_id<T>{}));
+}
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+
+extern "C" {
+#include <lua.h>
+}
+
+namespace sel {
+enum class GCMode {
+    Incremental,
+    Generational
+};
+
+struct GCStats {
+    // Bytes released by collections started through the State
+    std::size_t bytes_collected = 0;
+    std::size_t steps = 0;
+    std::size_t full_collections = 0;
+    std::chrono::microseconds total_pause{0};
+    std::chrono::microseconds max_pause{0};
+};
+
+/*
+ * Controls the collector of a lua_State and keeps track of the work
+ * done and the time spent in collections it started.
+ */
+class GarbageCollector {
+private:
+    lua_State *_l;
+    GCStats _stats;
+
+    using clock = std::chrono::steady_clock;
+
+    std::size_t _bytes() const {
+        return static_cast<std::size_t>(lua_gc(_l, LUA_GCCOUNT, 0)) * 1024
+            + static_cast<std::size_t>(lua_gc(_l, LUA_GCCOUNTB, 0));
+    }
+
+    void _record(std::size_t bytes_before, clock::time_point start) {
+        const std::size_t bytes_after = _bytes();
+        if (bytes_after < bytes_before) {
+            _stats.bytes_collected += bytes_before - bytes_after;
+        }
+        auto const pause = std::chrono::duration_cast<std::chrono::microseconds>(
+            clock::now() - start);
+        _stats.total_pause += pause;
+        _stats.max_pause = std::max(_stats.max_pause, pause);
+    }
+
+public:
+    explicit GarbageCollector(lua_State *l) : _l(l) {}
+
+    void SetState(lua_State *l) {
+        _l = l;
+    }
+
+    const GCStats &Stats() const {
+        return _stats;
+    }
+
+    // Returns false if the Lua version has no generational mode
+    bool SetMode(GCMode mode) {
+#if defined(LUA_GCGEN) && defined(LUA_GCINC)
+        lua_gc(_l, mode == GCMode::Generational ? LUA_GCGEN : LUA_GCINC, 0);
+        return true;
+#else
+        return mode == GCMode::Incremental;
+#endif
+    }
+
+    // Percentage of memory growth after a cycle before the next starts
+    void SetPause(int pause) {
+        lua_gc(_l, LUA_GCSETPAUSE, pause);
+    }
+
+    // Speed of the collector relative to allocation, in percent
+    void SetStepMultiplier(int stepmul) {
+        lua_gc(_l, LUA_GCSETSTEPMUL, stepmul);
+    }
+
+    void Collect() {
+        const std::size_t bytes_before = _bytes();
+        auto const start = clock::now();
+        lua_gc(_l, LUA_GCCOLLECT, 0);
+        ++_stats.full_collections;
+        _record(bytes_before, start);
+    }
+
+    // Performs basic collection steps until the budget is used up or a
+    // cycle finishes. Returns true if a cycle finished. At least one
+    // step is performed, so a step may overrun a tiny budget.
+    bool Step(std::chrono::microseconds budget) {
+        const std::size_t bytes_before = _bytes();
+        auto const start = clock::now();
+        auto const deadline = start + budget;
+        bool finished = false;
+        do {
+            finished = lua_gc(_l, LUA_GCSTEP, 0) != 0;
+            ++_stats.steps;
+        } while (!finished && clock::now() < deadline);
+        _record(bytes_before, start);
+        return finished;
+    }
+};
+}
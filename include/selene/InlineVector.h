@@ -0,0 +1,79 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace sel {
+namespace detail {
+/*
+ * Sequence that keeps its first N elements inside the object and only
+ * allocates once it grows beyond that. Used for the short lists that
+ * selectors build on every access so that the common case stays off
+ * the heap.
+ */
+template <typename T, std::size_t N>
+class InlineVector {
+private:
+    std::array<T, N> _inline;
+    std::vector<T> _overflow;
+    std::size_t _size;
+
+public:
+    InlineVector() : _size(0) {}
+
+    InlineVector(const InlineVector &) = default;
+    InlineVector & operator=(const InlineVector &) = default;
+
+    InlineVector(InlineVector &&other)
+        : _inline(std::move(other._inline)),
+          _overflow(std::move(other._overflow)),
+          _size(other._size) {
+        other._size = 0;
+    }
+
+    InlineVector & operator=(InlineVector &&other) {
+        if (&other == this) return *this;
+        _inline = std::move(other._inline);
+        _overflow = std::move(other._overflow);
+        _size = other._size;
+        other._size = 0;
+        return *this;
+    }
+
+    void push_back(T value) {
+        if (_size < N) {
+            _inline[_size] = std::move(value);
+        } else {
+            _overflow.push_back(std::move(value));
+        }
+        ++_size;
+    }
+
+    void clear() {
+        for (std::size_t i = 0; i < _size && i < N; ++i) {
+            _inline[i] = T{};
+        }
+        _overflow.clear();
+        _size = 0;
+    }
+
+    std::size_t size() const {
+        return _size;
+    }
+
+    bool empty() const {
+        return _size == 0;
+    }
+
+    const T &operator[](std::size_t i) const {
+        return i < N ? _inline[i] : _overflow[i - N];
+    }
+
+    const T &back() const {
+        return (*this)[_size - 1];
+    }
+};
+}
+}
@@ -1,6 +1,5 @@
 #pragma once
 
-#include <memory>
 #include <vector>
 #include "primitives.h"
 #include "ResourceHandler.h"
@@ -12,31 +11,68 @@ extern "C" {
 }
 
 namespace sel {
-namespace detail {
-class LuaRefDeleter {
+/*
+ * Owns a slot in the registry of a Lua state. The slot is released
+ * when the reference is destroyed. Slots are recycled through the free
+ * list luaL_ref keeps in the registry, so creating a reference never
+ * touches the C++ heap.
+ *
+ * References are move-only. Use Copy() to pin the same value in a
+ * second slot when an independent owner is needed.
+ */
+class LuaRef {
 private:
     lua_State *_state;
-public:
-    LuaRefDeleter(lua_State *state) : _state{state} {}
-    void operator()(int *ref) const {
-        luaL_unref(_state, LUA_REGISTRYINDEX, *ref);
-        delete ref;
+    int _ref;
+
+    void _release() {
+        if (_state != nullptr && _ref >= 0) {
+            luaL_unref(_state, LUA_REGISTRYINDEX, _ref);
+        }
+        _ref = LUA_NOREF;
     }
-};
-}
-class LuaRef {
-private:
-    std::shared_ptr<int> _ref;
+
 public:
+    LuaRef() : _state(nullptr), _ref(LUA_NOREF) {}
+
     LuaRef(lua_State *state, int ref)
-        : _ref(new int{ref}, detail::LuaRefDeleter{state}) {}
+        : _state(state), _ref(ref) {}
 
     LuaRef(lua_State *state)
         : LuaRef(state, LUA_REFNIL)
         {}
 
+    LuaRef(const LuaRef &) = delete;
+    LuaRef & operator=(const LuaRef &) = delete;
+
+    LuaRef(LuaRef &&other) noexcept
+        : _state(other._state), _ref(other._ref) {
+        other._ref = LUA_NOREF;
+    }
+
+    LuaRef & operator=(LuaRef &&other) noexcept {
+        if (&other == this) return *this;
+        _release();
+        _state = other._state;
+        _ref = other._ref;
+        other._ref = LUA_NOREF;
+        return *this;
+    }
+
+    ~LuaRef() {
+        _release();
+    }
+
+    LuaRef Copy() const {
+        if (_ref < 0) {
+            return LuaRef(_state, _ref);
+        }
+        lua_rawgeti(_state, LUA_REGISTRYINDEX, _ref);
+        return LuaRef(_state, luaL_ref(_state, LUA_REGISTRYINDEX));
+    }
+
     void Push(lua_State *state) const {
-        lua_rawgeti(state, LUA_REGISTRYINDEX, *_ref);
+        lua_rawgeti(state, LUA_REGISTRYINDEX, _ref);
     }
 };
 
@@ -47,10 +83,11 @@ LuaRef make_Ref(lua_State * state, T&& t) {
 }
 
 namespace detail {
-    inline void append_ref_recursive(lua_State *, std::vector<LuaRef> &) {}
+    template <typename Refs>
+    inline void append_ref_recursive(lua_State *, Refs &) {}
 
-    template <typename Head, typename... Tail>
-    void append_ref_recursive(lua_State * state, std::vector<LuaRef> & refs, Head&& head, Tail&&... tail) {
+    template <typename Refs, typename Head, typename... Tail>
+    void append_ref_recursive(lua_State * state, Refs & refs, Head&& head, Tail&&... tail) {
         refs.push_back(make_Ref(state, std::forward<Head>(head)));
 
         append_ref_recursive(state, refs, std::forward<Tail>(tail)...);
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <utility>
+
+#if defined(_WIN32)
+#include <fstream>
+#include <iterator>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace sel {
+/*
+ * Read-only view of a whole file. The file is mapped into memory where
+ * the platform supports it and read into a buffer otherwise. An empty
+ * file is valid and has no data.
+ */
+class MappedFile {
+private:
+    const char *_data = nullptr;
+    std::size_t _size = 0;
+    bool _valid = false;
+    bool _mapped = false;
+    std::string _buffer;
+
+    void _read(const std::string &path) {
+#if defined(_WIN32)
+        std::ifstream in(path, std::ios::in | std::ios::binary);
+        if (!in) return;
+        _buffer.assign(std::istreambuf_iterator<char>(in),
+                       std::istreambuf_iterator<char>());
+        if (in.bad()) return;
+#else
+        const int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return;
+        struct stat info;
+        if (::fstat(fd, &info) != 0 || !S_ISREG(info.st_mode)) {
+            ::close(fd);
+            return;
+        }
+        _size = static_cast<std::size_t>(info.st_size);
+        if (_size > 0) {
+            void *data = ::mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (data != MAP_FAILED) {
+                _data = static_cast<const char *>(data);
+                _mapped = true;
+            } else {
+                // Fall back to reading, e.g. on file systems without mmap
+                _buffer.resize(_size);
+                std::size_t done = 0;
+                while (done < _size) {
+                    const ssize_t n = ::read(fd, &_buffer[done], _size - done);
+                    if (n <= 0) break;
+                    done += static_cast<std::size_t>(n);
+                }
+                _buffer.resize(done);
+            }
+        }
+        ::close(fd);
+#endif
+        if (!_mapped) {
+            _data = _buffer.data();
+            _size = _buffer.size();
+        }
+        _valid = true;
+    }
+
+    void _unmap() {
+#if !defined(_WIN32)
+        if (_mapped) {
+            ::munmap(const_cast<char *>(_data), _size);
+        }
+#endif
+        _data = nullptr;
+        _size = 0;
+        _valid = false;
+        _mapped = false;
+        _buffer.clear();
+    }
+
+public:
+    MappedFile() = default;
+    explicit MappedFile(const std::string &path) {
+        _read(path);
+    }
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    MappedFile(MappedFile &&other) {
+        *this = std::move(other);
+    }
+
+    MappedFile &operator=(MappedFile &&other) {
+        if (&other == this) return *this;
+        _unmap();
+        _valid = other._valid;
+        _mapped = other._mapped;
+        _buffer = std::move(other._buffer);
+        _size = other._size;
+        _data = _mapped ? other._data : _buffer.data();
+        other._mapped = false;
+        other._unmap();
+        return *this;
+    }
+
+    ~MappedFile() {
+        _unmap();
+    }
+
+    // False if the file could not be opened or read
+    bool Valid() const {
+        return _valid;
+    }
+
+    const char *Data() const {
+        return _data;
+    }
+
+    std::size_t Size() const {
+        return _size;
+    }
+};
+}
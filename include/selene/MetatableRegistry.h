@@ -22,20 +22,38 @@ namespace MetatableRegistry {
 using TypeID = std::reference_wrapper<const std::type_info>;
 namespace detail {
 
-static inline void _create_table_in_registry(lua_State *state, const std::string & name) {
-    lua_pushlstring(state, name.c_str(), name.size());
+/*
+ * Registry tables and type tags are keyed by the address of these
+ * statics, so each lookup is a raw pointer-keyed access instead of
+ * hashing a string. The functions have external linkage to make the
+ * addresses identical in every translation unit.
+ */
+inline void *_names_key() {
+    static char key;
+    return &key;
+}
+
+inline void *_metatables_key() {
+    static char key;
+    return &key;
+}
+
+inline void *_type_tag_key() {
+    static char key;
+    return &key;
+}
+
+static inline void _create_table_in_registry(lua_State *state, void *key) {
     lua_newtable(state);
-    lua_settable(state, LUA_REGISTRYINDEX);
+    lua_rawsetp(state, LUA_REGISTRYINDEX, key);
 }
 
 static inline void _push_names_table(lua_State *state) {
-    lua_pushliteral(state, "selene_metatable_names");
-    lua_gettable(state, LUA_REGISTRYINDEX);
+    lua_rawgetp(state, LUA_REGISTRYINDEX, _names_key());
 }
 
 static inline void _push_meta_table(lua_State *state) {
-    lua_pushliteral(state, "selene_metatables");
-    lua_gettable(state, LUA_REGISTRYINDEX);
+    lua_rawgetp(state, LUA_REGISTRYINDEX, _metatables_key());
 }
 
 static inline void _push_typeinfo(lua_State *state, TypeID type) {
@@ -44,36 +62,36 @@ static inline void _push_typeinfo(lua_State *state, TypeID type) {
 
 static inline void _get_metatable(lua_State *state, TypeID type) {
     detail::_push_meta_table(state);
-    detail::_push_typeinfo(state, type);
-    lua_gettable(state, -2);
+    lua_rawgetp(state, -1, &type.get());
     lua_remove(state, -2);
 }
 
 }
 
 static inline void Create(lua_State *state) {
-    detail::_create_table_in_registry(state, "selene_metatable_names");
-    detail::_create_table_in_registry(state, "selene_metatables");
+    detail::_create_table_in_registry(state, detail::_names_key());
+    detail::_create_table_in_registry(state, detail::_metatables_key());
 }
 
 static inline void PushNewMetatable(lua_State *state, TypeID type, const std::string& name) {
     detail::_push_names_table(state);
 
-    detail::_push_typeinfo(state, type);
     lua_pushlstring(state, name.c_str(), name.size());
-    lua_settable(state, -3);
+    lua_rawsetp(state, -2, &type.get());
 
     lua_pop(state, 1);
 
 
     luaL_newmetatable(state, name.c_str()); // Actual result.
 
+    // Tag the metatable with its type so IsType is a pointer compare
+    detail::_push_typeinfo(state, type);
+    lua_rawsetp(state, -2, detail::_type_tag_key());
 
     detail::_push_meta_table(state);
 
-    detail::_push_typeinfo(state, type);
-    lua_pushvalue(state, -3);
-    lua_settable(state, -3);
+    lua_pushvalue(state, -2);
+    lua_rawsetp(state, -2, &type.get());
 
     lua_pop(state, 1);
 }
@@ -92,8 +110,7 @@ static inline bool SetMetatable(lua_State *state, TypeID type) {
 
 static inline bool IsRegisteredType(lua_State *state, TypeID type) {
     detail::_push_names_table(state);
-    detail::_push_typeinfo(state, type);
-    lua_gettable(state, -2);
+    lua_rawgetp(state, -1, &type.get());
 
     bool registered = lua_isstring(state, -1);
     lua_pop(state, 2);
@@ -104,8 +121,7 @@ static inline std::string GetTypeName(lua_State *state, TypeID type) {
     std::string name("unregistered type");
 
     detail::_push_names_table(state);
-    detail::_push_typeinfo(state, type);
-    lua_gettable(state, -2);
+    lua_rawgetp(state, -1, &type.get());
 
     if(lua_isstring(state, -1)) {
         size_t len = 0;
@@ -144,13 +160,12 @@ static inline bool IsType(lua_State *state, TypeID type, const int index) {
     bool equal = true;
 
     if(lua_getmetatable(state, index)) {
-        detail::_get_metatable(state, type);
-        equal = lua_istable(state, -1) && lua_rawequal(state, -1, -2);
+        // Every metatable created by PushNewMetatable carries its type
+        lua_rawgetp(state, -1, detail::_type_tag_key());
+        equal = lua_touserdata(state, -1) == &type.get();
         lua_pop(state, 2);
     } else {
-        detail::_get_metatable(state, type);
-        equal = !lua_istable(state, -1);
-        lua_pop(state, 1);
+        equal = !IsRegisteredType(state, type);
     }
 
     return equal;
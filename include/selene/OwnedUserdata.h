@@ -0,0 +1,68 @@
+#pragma once
+
+extern "C" {
+#include <lua.h>
+#include <lauxlib.h>
+}
+
+namespace sel {
+namespace detail {
+/*
+ * Full userdata created by Selene (class instances and stored
+ * exceptions) are recorded in a weak table in the registry from the
+ * moment they are created, so that their finalizers can be run on
+ * teardown without a full collection or lua_close, whenever the state
+ * is switched to Teardown::FinalizeOwned.
+ */
+inline void *_owned_userdata_key() {
+    static char key;
+    return &key;
+}
+
+// Records the userdata on top of the stack, creating the table on first use
+inline void _track_owned_userdata(lua_State *l) {
+    lua_rawgetp(l, LUA_REGISTRYINDEX, _owned_userdata_key());
+    if (!lua_istable(l, -1)) {
+        lua_pop(l, 1);
+        lua_newtable(l);
+        lua_createtable(l, 0, 1);
+        lua_pushliteral(l, "k");
+        lua_setfield(l, -2, "__mode");
+        lua_setmetatable(l, -2);
+        lua_pushvalue(l, -1);
+        lua_rawsetp(l, LUA_REGISTRYINDEX, _owned_userdata_key());
+    }
+    lua_pushvalue(l, -2);
+    lua_pushboolean(l, 1);
+    lua_rawset(l, -3);
+    lua_pop(l, 1);
+}
+
+// Called by finalizers once the C++ object is destroyed, so that the
+// userdata cannot be finalized a second time.
+inline void _mark_finalized(lua_State *l, int index) {
+    lua_pushnil(l);
+    lua_setmetatable(l, index);
+}
+
+// Runs the __gc metamethod of every recorded userdata
+inline void _finalize_owned_userdata(lua_State *l) {
+    lua_rawgetp(l, LUA_REGISTRYINDEX, _owned_userdata_key());
+    if (!lua_istable(l, -1)) {
+        lua_pop(l, 1);
+        return;
+    }
+    lua_pushnil(l);
+    while (lua_next(l, -2) != 0) {
+        lua_pop(l, 1);
+        if (luaL_getmetafield(l, -1, "__gc")) {
+            lua_pushvalue(l, -2);
+            if (lua_pcall(l, 1, 0, 0) != 0) {
+                lua_pop(l, 1);
+            }
+        }
+    }
+    lua_pop(l, 1);
+}
+}
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include "BaseFun.h"
+#include <string>
+#include <type_traits>
+
+namespace sel {
+/*
+ * Marks a data member passed to SetClass as a property. Properties are
+ * read and written as plain fields from Lua (obj.x, obj.x = 5) instead
+ * of through generated getter and setter methods.
+ *
+ *     state["Bar"].SetClass<Bar, int>("x", sel::property(&Bar::x));
+ */
+template <typename T, typename M>
+struct PropertyMember {
+    M T::*member;
+};
+
+template <typename T, typename M>
+inline PropertyMember<T, M> property(M T::*member) {
+    return PropertyMember<T, M>{member};
+}
+
+struct BaseProperty {
+    virtual ~BaseProperty() {}
+    virtual bool IsReadOnly() const = 0;
+
+    // Self is at stack index 1 and the value to store at index 3
+    virtual int Get(lua_State *state) = 0;
+    virtual int Set(lua_State *state) = 0;
+};
+
+template <typename T, typename M>
+class Property : public BaseProperty {
+private:
+    M T::*_member;
+    std::string _metatable_name;
+
+    int _set(lua_State *l, std::false_type) {
+        T *self = detail::_get_self<T>(l, _metatable_name);
+        self->*_member = detail::_check_get(detail::_id<M>{}, l, 3);
+        return 0;
+    }
+
+    int _set(lua_State *, std::true_type) {
+        return 0;
+    }
+
+public:
+    Property(M T::*member, const std::string &metatable_name)
+        : _member(member), _metatable_name(metatable_name) {}
+
+    bool IsReadOnly() const {
+        return std::is_const<M>::value;
+    }
+
+    int Get(lua_State *l) {
+        T *self = detail::_get_self<T>(l, _metatable_name);
+        using value_type = typename std::remove_const<M>::type;
+        detail::_push(l, static_cast<value_type>(self->*_member));
+        return 1;
+    }
+
+    int Set(lua_State *l) {
+        return _set(l, typename std::is_const<M>::type{});
+    }
+};
+
+namespace detail {
+
+// __index of classes with properties. Upvalue 1 maps field names to
+// BaseProperty objects, upvalue 2 is the metatable holding the methods.
+inline int _property_index(lua_State *l) {
+    lua_pushvalue(l, 2);
+    lua_rawget(l, lua_upvalueindex(1));
+    BaseProperty *prop = (BaseProperty *)lua_touserdata(l, -1);
+    lua_pop(l, 1);
+    if (prop != nullptr) {
+        return _dispatch(l, [prop](lua_State *state) {
+            return prop->Get(state);
+        });
+    }
+    lua_pushvalue(l, 2);
+    lua_rawget(l, lua_upvalueindex(2));
+    return 1;
+}
+
+// __newindex of classes with properties. Upvalue 1 maps field names to
+// BaseProperty objects.
+inline int _property_newindex(lua_State *l) {
+    lua_pushvalue(l, 2);
+    lua_rawget(l, lua_upvalueindex(1));
+    BaseProperty *prop = (BaseProperty *)lua_touserdata(l, -1);
+    lua_pop(l, 1);
+    if (prop == nullptr || prop->IsReadOnly()) {
+        return luaL_error(l, "cannot assign to field '%s'",
+                          luaL_tolstring(l, 2, nullptr));
+    }
+    return _dispatch(l, [prop](lua_State *state) {
+        return prop->Set(state);
+    });
+}
+}
+}
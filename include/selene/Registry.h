@@ -5,6 +5,8 @@
 #include "Fun.h"
 #include "MetatableRegistry.h"
 #include "Obj.h"
+#include "StaticFun.h"
+#include <type_traits>
 #include "util.h"
 #include <vector>
 
@@ -16,6 +18,7 @@ struct lambda_traits : public lambda_traits<decltype(&T::operator())> {};
 template <typename T, typename Ret, typename... Args>
 struct lambda_traits<Ret(T::*)(Args...) const> {
     using Fun = std::function<Ret(Args...)>;
+    using FunPtr = Ret(*)(Args...);
 };
 }
 class Registry {
@@ -31,6 +34,18 @@ public:
 
     template <typename L>
     void Register(L lambda) {
+        using FunPtr = typename detail::lambda_traits<L>::FunPtr;
+        _register_lambda(lambda, typename std::is_convertible<L, FunPtr>::type{});
+    }
+
+    // Lambdas without captures decay to plain function pointers
+    template <typename L>
+    void _register_lambda(L lambda, std::true_type) {
+        Register(static_cast<typename detail::lambda_traits<L>::FunPtr>(lambda));
+    }
+
+    template <typename L>
+    void _register_lambda(L lambda, std::false_type) {
         Register((typename detail::lambda_traits<L>::Fun)(lambda));
     }
 
@@ -44,10 +59,12 @@ public:
 
     template <typename Ret, typename... Args>
     void Register(Ret (*fun)(Args...)) {
-        constexpr int arity = detail::_arity<Ret>::value;
-        _funs.emplace_back(
-            sel::make_unique<Fun<arity, Ret, Args...>>(
-                _state, fun));
+        detail::_push_fun_ptr(_state, fun);
+    }
+
+    template <typename F, F f>
+    void Register(StaticFun<F, f>) {
+        lua_pushcfunction(_state, (&detail::_static_fun<F, f>::call));
     }
 
     template <typename T, typename... Funs>
@@ -1,14 +1,20 @@
 #pragma once
 
 #include "ExceptionHandler.h"
+#include "CallBatch.h"
 #include "function.h"
 #include <functional>
+#include "InlineVector.h"
 #include "LuaRef.h"
+#include <map>
 #include "references.h"
 #include "Registry.h"
 #include "ResourceHandler.h"
+#include "SelectorPath.h"
+#include "TableIterator.h"
 #include <string>
 #include <tuple>
+#include <unordered_map>
 #include "util.h"
 #include <vector>
 
@@ -40,142 +46,173 @@
 
 namespace sel {
 class State;
+class BoundSelector;
 class Selector {
     friend class State;
+    friend class BoundSelector;
 private:
     lua_State *_state;
     Registry *_registry;
     ExceptionHandler *_exception_handler;
-    std::string _name;
 
-    // Traverses the structure up to this element
-    std::vector<LuaRef> _traversal;
+    // Keys leading from the global table to this element. They are
+    // only looked up when the selector is evaluated.
+    detail::SelectorPath _path;
 
-    // Key of the value to act upon.
-    LuaRef _key;
-
-    std::vector<LuaRef> _functor_arguments;
+    detail::InlineVector<LuaRef, 4> _functor_arguments;
 
     // Functor is activated when the () operator is invoked.
     mutable  MovingFlag _functor_active;
 
-    Selector(lua_State *s, Registry &r, ExceptionHandler &eh, const std::string &name,
-             std::vector<LuaRef> traversal, LuaRef key)
-        : _state(s), _registry(&r), _exception_handler(&eh), _name(name), _traversal(traversal),
-          _key(key) {}
+    Selector(lua_State *s, Registry &r, ExceptionHandler &eh, detail::SelectorKey name)
+        : _state(s), _registry(&r), _exception_handler(&eh) {
+        _path.push_back(std::move(name));
+    }
 
-    Selector(lua_State *s, Registry &r, ExceptionHandler &eh, const std::string& name)
-        : _state(s), _registry(&r), _exception_handler(&eh), _name(name),
-          _key(make_Ref(s, name)) {}
+    // Selects the element at path, with no call arguments
+    Selector(const Selector &other, const detail::SelectorPath &path)
+        : _state(other._state), _registry(other._registry),
+          _exception_handler(other._exception_handler), _path(path) {}
 
-    void _get(LuaRef r) const {
-        r.Push(_state);
-        lua_gettable(_state, -2);
-        lua_remove(_state, lua_absindex(_state, -2));
+    // Selects key within the element selected by parent
+    Selector(const Selector &parent, detail::SelectorKey key)
+        : _state(parent._state), _registry(parent._registry),
+          _exception_handler(parent._exception_handler), _path(parent._path) {
+        _path.push_back(std::move(key));
+    }
+
+    // True for tables and for values with an __index metamethod, such
+    // as instances of registered classes
+    bool _indexable() const {
+        if (lua_istable(_state, -1)) return true;
+        if (!luaL_getmetafield(_state, -1, "__index")) return false;
+        lua_pop(_state, 1);
+        return true;
+    }
+
+    // Replaces the value on top of the stack with the value stored
+    // under key, honouring __index. Values that cannot be indexed, such
+    // as nil, yield nil instead of raising an error.
+    void _get(const detail::SelectorKey &key) const {
+        if (_indexable()) {
+            key.Push(_state);
+            lua_gettable(_state, -2);
+            lua_remove(_state, lua_absindex(_state, -2));
+        } else {
+            lua_pop(_state, 1);
+            lua_pushnil(_state);
+        }
     }
 
     // Pushes this element to the stack
     void _get() const {
-        _get(_key);
+        _get(_path.back());
     }
 
     // Sets this element from a function that pushes a value to the
     // stack.
     template<typename PushFunction>
     void _put(PushFunction fun) const {
-        _key.Push(_state);
+        _path.back().Push(_state);
         fun();
         lua_settable(_state, -3);
         lua_pop(_state, 1);
     }
 
-    void _check_create_table() const {
-        ResetStackOnScopeExit save(_state);
-        _traverse();
-        _get();
-        if (lua_istable(_state, -1) == 0 ) { // not table
-            lua_pop(_state, 1); // flush the stack
-            auto put = [this]() {
-                lua_newtable(_state);
-            };
-            _traverse();
-            _put(put);
-        }
-    }
-
-    void _traverse() const {
+    // Pushes the value holding this element to the stack. Intermediate
+    // values that cannot be indexed are only replaced by new tables when
+    // create_tables is set, otherwise the walk yields nil.
+    void _traverse(bool create_tables = false) const {
         lua_pushglobaltable(_state);
-        for (auto &key : _traversal) {
-            _get(key);
+        for (std::size_t i = 0; i + 1 < _path.size(); ++i) {
+            if (!create_tables) {
+                _get(_path[i]);
+                continue;
+            }
+            _path[i].Push(_state);
+            lua_gettable(_state, -2);
+            if (!_indexable()) {
+                lua_pop(_state, 1);
+                lua_newtable(_state);
+                _path[i].Push(_state);
+                lua_pushvalue(_state, -2);
+                lua_settable(_state, -4);
+            }
+            lua_remove(_state, lua_absindex(_state, -2));
         }
     }
 
     template <typename Fun>
     void _evaluate_store(Fun&& push) const {
         ResetStackOnScopeExit save(_state);
-        _traverse();
+        _traverse(true);
         _put(std::forward<Fun>(push));
     }
 
-    void _evaluate_retrieve(int num_results) const {
-        _traverse();
-        _get();
-        _evaluate_function_call(num_results);
+    // Index of the message handler for calls made by this selector.
+    // A handler pinned by a CallBatch is reused, otherwise one is pushed.
+    int _use_error_handler() const {
+        return UseErrorHandler(_state, _exception_handler->MessageHandlerIndex());
     }
 
-    void _evaluate_function_call(int num_ret) const {
-        if(!_functor_active) return;
+    // Pushes this element, or the results of calling it if the functor
+    // is active, and returns the stack index of the first of them.
+    int _evaluate_retrieve(int num_results) const {
+        if (!_functor_active) {
+            _traverse();
+            _get();
+            return lua_gettop(_state);
+        }
         _functor_active = false;
-        // install handler, and swap(handler, function) on lua stack
-        int handler_index = SetErrorHandler(_state);
-        int func_index = handler_index - 1;
-#if LUA_VERSION_NUM >= 502
-        lua_pushvalue(_state, func_index);
-        lua_copy(_state, handler_index, func_index);
-        lua_replace(_state, handler_index);
-#else
-        lua_pushvalue(_state, func_index);
-        lua_push_value(_state, handler_index);
-        lua_replace(_state, func_index);
-        lua_replace(_state, handler_index);
-#endif
-        // call lua function with error handler
-        for(auto const & arg : _functor_arguments) {
-            arg.Push(_state);
+        // install the handler below the function so no shuffling is needed
+        int const handler_index = _use_error_handler();
+        int const first_result = lua_gettop(_state) + 1;
+        _traverse();
+        _get();
+        for(std::size_t i = 0; i < _functor_arguments.size(); ++i) {
+            _functor_arguments[i].Push(_state);
         }
         auto const statusCode =
-            lua_pcall(_state, _functor_arguments.size(), num_ret, handler_index - 1);
-
-        // remove error handler
-        lua_remove(_state, handler_index - 1);
+            detail::_pcall(_state, _functor_arguments.size(), num_results, handler_index);
 
         if (statusCode != LUA_OK) {
             _exception_handler->Handle_top_of_stack(statusCode, _state);
         }
+        return first_result;
     }
 public:
 
-    Selector(const Selector &) = default;
+    Selector(const Selector &other)
+        : _state(other._state), _registry(other._registry),
+          _exception_handler(other._exception_handler), _path(other._path),
+          _functor_active(other._functor_active) {
+        for (std::size_t i = 0; i < other._functor_arguments.size(); ++i) {
+            _functor_arguments.push_back(other._functor_arguments[i].Copy());
+        }
+    }
     Selector(Selector &&) = default;
-    Selector & operator=(const Selector &) = default;
+    Selector & operator=(const Selector &other) {
+        if (&other == this) return *this;
+        Selector copy{other};
+        *this = std::move(copy);
+        return *this;
+    }
     Selector & operator=(Selector &&) = default;
 
     ~Selector() noexcept(false) {
         // If there is a functor is not empty, execute it and collect no args
         if (_functor_active) {
             ResetStackOnScopeExit save(_state);
-            _traverse();
-            _get();
             if (std::uncaught_exception())
             {
                 try {
-                    _evaluate_function_call(0);
+                    _evaluate_retrieve(0);
                 } catch (...) {
                     // We are already unwinding, ignore further exceptions.
                     // As of C++17 consider std::uncaught_exceptions()
                 }
             } else {
-                _evaluate_function_call(0);
+                _evaluate_retrieve(0);
             }
         }
     }
@@ -185,15 +222,41 @@ public:
 
     template <typename... Args>
     const Selector operator()(Args&&... args) const {
-        Selector copy{*this};
-        const auto state = _state; // gcc-5.1 doesn't support implicit member capturing
-        const auto eh = _exception_handler;
-        copy._functor_arguments = make_Refs(_state, std::forward<Args>(args)...);
-        copy._functor_active = true;
-        return copy;
+        // Built from the path alone, so the arguments of this selector
+        // are not copied only to be replaced
+        Selector call{*this, _path};
+        detail::append_ref_recursive(_state, call._functor_arguments,
+                                     std::forward<Args>(args)...);
+        call._functor_active = true;
+        return call;
+    }
+
+    // Calls the selected Lua function right away and returns its
+    // results as R (void, a single value or a std::tuple). Unlike
+    // operator(), the arguments are pushed straight onto the Lua stack
+    // instead of being stored in the registry first.
+    template <typename R = void, typename... Args>
+    R Call(Args&&... args) const {
+        ResetStackOnScopeExit save(_state);
+        int const handler_index = _use_error_handler();
+        int const first_result = lua_gettop(_state) + 1;
+        _traverse();
+        _get();
+        detail::_push_n(_state, std::forward<Args>(args)...);
+        constexpr int num_args = sizeof...(Args);
+        constexpr int num_ret = detail::_arity<R>::value;
+        auto const statusCode =
+            detail::_pcall(_state, num_args, num_ret, handler_index);
+        if (statusCode != LUA_OK) {
+            _exception_handler->Handle_top_of_stack(statusCode, _state);
+        }
+        return detail::_call_results<R>::get(_state, first_result);
     }
 
-    template <typename L>
+    template <
+        typename L,
+        typename = typename std::enable_if<!detail::_has_fields<L>::value>::type
+    >
     void operator=(L lambda) const {
         _evaluate_store([this, lambda]() {
             _registry->Register(lambda);
@@ -251,6 +314,56 @@ public:
         });
     }
 
+    template <typename T>
+    void operator=(const std::vector<T> &values) const {
+        _evaluate_store([this, &values]() {
+            detail::_push(_state, values);
+        });
+    }
+
+    template <typename T, std::size_t N>
+    void operator=(const std::array<T, N> &values) const {
+        _evaluate_store([this, &values]() {
+            detail::_push(_state, values);
+        });
+    }
+
+    template <typename K, typename V, typename C, typename A>
+    void operator=(const std::map<K, V, C, A> &entries) const {
+        _evaluate_store([this, &entries]() {
+            detail::_push(_state, entries);
+        });
+    }
+
+    template <typename K, typename V, typename H, typename E, typename A>
+    void operator=(const std::unordered_map<K, V, H, E, A> &entries) const {
+        _evaluate_store([this, &entries]() {
+            detail::_push(_state, entries);
+        });
+    }
+
+    template <typename T>
+    typename std::enable_if<detail::_has_fields<T>::value>::type
+    operator=(const T &value) const {
+        _evaluate_store([this, &value]() {
+            detail::_push(_state, value);
+        });
+    }
+
+    template <typename T>
+    void operator=(ArrayView<T> view) const {
+        _evaluate_store([this, view]() {
+            detail::_push(_state, view);
+        });
+    }
+
+    template <typename F, F f>
+    void operator=(StaticFun<F, f> fun) const {
+        _evaluate_store([this, fun]() {
+            _registry->Register(fun);
+        });
+    }
+
     template <typename Ret, typename... Args>
     void operator=(Ret (*fun)(Args...)) {
         _evaluate_store([this, fun]() {
@@ -277,15 +390,15 @@ public:
         auto fun_tuple = std::make_tuple(std::forward<Funs>(funs)...);
         _evaluate_store([this, &fun_tuple]() {
             typename detail::_indices_builder<sizeof...(Funs)>::type d;
-            _registry->RegisterClass<T, Args...>(_name, fun_tuple, d);
+            _registry->RegisterClass<T, Args...>(_path.ToString(), fun_tuple, d);
         });
     }
 
     template <typename... Ret>
     std::tuple<Ret...> GetTuple() const {
         ResetStackOnScopeExit save(_state);
-        _evaluate_retrieve(sizeof...(Ret));
-        return detail::_get_n<Ret...>(_state);
+        int const first = _evaluate_retrieve(sizeof...(Ret));
+        return detail::_call_results<std::tuple<Ret...>>::get(_state, first);
     }
 
     template<
@@ -351,6 +464,44 @@ public:
         return detail::_pop(detail::_id<std::string>{}, _state);
     }
 
+    template <typename T>
+    operator std::vector<T>() const {
+        ResetStackOnScopeExit save(_state);
+        _evaluate_retrieve(1);
+        return detail::_pop(detail::_id<std::vector<T>>{}, _state);
+    }
+
+    template <typename T, std::size_t N>
+    operator std::array<T, N>() const {
+        ResetStackOnScopeExit save(_state);
+        _evaluate_retrieve(1);
+        return detail::_pop(detail::_id<std::array<T, N>>{}, _state);
+    }
+
+    template <typename K, typename V, typename C, typename A>
+    operator std::map<K, V, C, A>() const {
+        ResetStackOnScopeExit save(_state);
+        _evaluate_retrieve(1);
+        return detail::_pop(detail::_id<std::map<K, V, C, A>>{}, _state);
+    }
+
+    template <typename K, typename V, typename H, typename E, typename A>
+    operator std::unordered_map<K, V, H, E, A>() const {
+        ResetStackOnScopeExit save(_state);
+        _evaluate_retrieve(1);
+        return detail::_pop(detail::_id<std::unordered_map<K, V, H, E, A>>{}, _state);
+    }
+
+    template <
+        typename T,
+        typename = typename std::enable_if<detail::_has_fields<T>::value>::type
+    >
+    operator T() const {
+        ResetStackOnScopeExit save(_state);
+        _evaluate_retrieve(1);
+        return detail::_pop(detail::_id<T>{}, _state);
+    }
+
     template <typename R, typename... Args>
     operator sel::function<R(Args...)>() {
         ResetStackOnScopeExit save(_state);
@@ -362,42 +513,52 @@ public:
     }
 
     // Chaining operators. If the selector is an rvalue, modify in
-    // place. Otherwise, create a new Selector and return it.
+    // place. Otherwise, create a new Selector and return it. Keys are
+    // only recorded here; tables are looked up on evaluation and
+    // created on assignment. Names given as const char arrays, such as
+    // string literals, are not copied and must outlive the selector.
 #ifdef HAS_REF_QUALIFIERS
     Selector&& operator[](const std::string& name) && {
-        _name += std::string(".") + name;
-        _check_create_table();
-        _traversal.push_back(_key);
-        _key = make_Ref(_state, name);
+        _path.push_back(detail::SelectorKey{name});
+        return std::move(*this);
+    }
+    template <std::size_t N>
+    Selector&& operator[](const char (&name)[N]) && {
+        _path.push_back(detail::SelectorKey::Literal(name));
+        return std::move(*this);
+    }
+    template <std::size_t N>
+    Selector&& operator[](char (&name)[N]) && {
+        _path.push_back(detail::SelectorKey{static_cast<const char *>(name)});
         return std::move(*this);
     }
-    Selector&& operator[](const char* name) && {
-        return std::move(*this)[std::string{name}];
+    template <typename T, typename = detail::_enable_if_c_string<T>>
+    Selector&& operator[](T name) && {
+        _path.push_back(detail::SelectorKey{static_cast<const char *>(name)});
+        return std::move(*this);
     }
     Selector&& operator[](const int index) && {
-        _name += std::string(".") + std::to_string(index);
-        _check_create_table();
-        _traversal.push_back(_key);
-        _key = make_Ref(_state, index);
+        _path.push_back(detail::SelectorKey{index});
         return std::move(*this);
     }
 #endif // HAS_REF_QUALIFIERS
     Selector operator[](const std::string& name) const REF_QUAL_LVALUE {
-        auto n = _name + "." + name;
-        _check_create_table();
-        auto traversal = _traversal;
-        traversal.push_back(_key);
-        return Selector{_state, *_registry, *_exception_handler, n, traversal, make_Ref(_state, name)};
+        return Selector{*this, detail::SelectorKey{name}};
+    }
+    template <std::size_t N>
+    Selector operator[](const char (&name)[N]) const REF_QUAL_LVALUE {
+        return Selector{*this, detail::SelectorKey::Literal(name)};
+    }
+    template <std::size_t N>
+    Selector operator[](char (&name)[N]) const REF_QUAL_LVALUE {
+        return Selector{*this, detail::SelectorKey{static_cast<const char *>(name)}};
     }
-    Selector operator[](const char* name) const REF_QUAL_LVALUE {
-        return (*this)[std::string{name}];
+    template <typename T, typename = detail::_enable_if_c_string<T>>
+    Selector operator[](T name) const REF_QUAL_LVALUE {
+        return Selector{*this, detail::SelectorKey{static_cast<const char *>(name)}};
     }
     Selector operator[](const int index) const REF_QUAL_LVALUE {
-        auto name = _name + "." + std::to_string(index);
-        _check_create_table();
-        auto traversal = _traversal;
-        traversal.push_back(_key);
-        return Selector{_state, *_registry, *_exception_handler, name, traversal, make_Ref(_state, index)};
+        return Selector{*this, detail::SelectorKey{index}};
     }
 
     friend bool operator==(const Selector &, const char *);
@@ -411,6 +572,43 @@ public:
 
         return !lua_isnil(_state, -1);
     }
+
+    // Length of the array part of the table, 0 for other values
+    std::size_t Size() const {
+        ResetStackOnScopeExit save(_state);
+        _evaluate_retrieve(1);
+        return lua_istable(_state, -1) ? lua_rawlen(_state, -1) : 0;
+    }
+
+    // Pins the table on the stack and returns a range over its entries:
+    //
+    //     for (auto entry : state["t"].Pairs()) {
+    //         entry.Key<std::string>(); entry.Value<int>();
+    //     }
+    TableRange Pairs() const {
+        const int base = lua_gettop(_state);
+        int table;
+        try {
+            table = _evaluate_retrieve(1);
+        } catch (...) {
+            lua_settop(_state, base);
+            throw;
+        }
+        return TableRange{_state, base, table};
+    }
+
+    // Calls fn(key, value) for every entry of the table in one traversal
+    template <typename K, typename V, typename F>
+    void ForEach(F fn) const {
+        for (auto entry : Pairs()) {
+            fn(entry.Key<K>(), entry.Value<V>());
+        }
+    }
+
+    // Resolves the table holding this element once and returns a
+    // handle that reads and writes the element without traversing
+    // from the global table again.
+    BoundSelector Bind() const;
 private:
     std::string ToString() const {
         ResetStackOnScopeExit save(_state);
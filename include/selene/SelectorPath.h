@@ -0,0 +1,106 @@
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+#include "InlineVector.h"
+#include <string>
+#include <type_traits>
+#include <utility>
+
+extern "C" {
+#include <lua.h>
+}
+
+namespace sel {
+namespace detail {
+/*
+ * A single table key of a Selector, held as a plain C++ value until
+ * the selector is evaluated. String literals are kept by address and
+ * other names are copied, so building a key does not touch the
+ * registry, nor the heap unless a copied name is long.
+ */
+class SelectorKey {
+private:
+    std::string _name;
+    // Set for borrowed names only
+    const char *_literal;
+    std::size_t _size;
+    int _index;
+    bool _is_index;
+
+public:
+    SelectorKey() : _literal(nullptr), _size(0), _index(0), _is_index(false) {}
+    SelectorKey(const std::string &name)
+        : _name(name), _literal(nullptr), _size(0), _index(0), _is_index(false) {}
+    SelectorKey(const char *name)
+        : _name(name), _literal(nullptr), _size(0), _index(0), _is_index(false) {}
+    SelectorKey(int index)
+        : _literal(nullptr), _size(0), _index(index), _is_index(true) {}
+
+    // Refers to name without copying it. It must outlive the key.
+    static SelectorKey Literal(const char *name) {
+        SelectorKey key;
+        key._literal = name;
+        key._size = std::strlen(name);
+        return key;
+    }
+
+    void Push(lua_State *l) const {
+        if (_is_index) {
+            lua_pushinteger(l, _index);
+        } else if (_literal != nullptr) {
+            lua_pushlstring(l, _literal, _size);
+        } else {
+            lua_pushlstring(l, _name.data(), _name.size());
+        }
+    }
+
+    std::string ToString() const {
+        if (_is_index) return std::to_string(_index);
+        return _literal != nullptr ? std::string{_literal, _size} : _name;
+    }
+};
+
+// Enables overloads taking a C string by pointer, which lose against
+// the overloads taking string literals by reference
+template <typename T>
+using _enable_if_c_string = typename std::enable_if<
+    std::is_same<T, const char *>::value || std::is_same<T, char *>::value>::type;
+
+/*
+ * The chain of keys leading from the global table to the element a
+ * Selector refers to. The last key is the element itself.
+ */
+class SelectorPath {
+private:
+    InlineVector<SelectorKey, 6> _keys;
+
+public:
+    void push_back(SelectorKey key) {
+        _keys.push_back(std::move(key));
+    }
+
+    std::size_t size() const {
+        return _keys.size();
+    }
+
+    const SelectorKey &operator[](std::size_t i) const {
+        return _keys[i];
+    }
+
+    const SelectorKey &back() const {
+        return _keys.back();
+    }
+
+    // Dotted name of the path, e.g. "my_table.nested.2"
+    std::string ToString() const {
+        std::string name;
+        for (std::size_t i = 0; i < _keys.size(); ++i) {
+            if (i != 0) name += ".";
+            name += (*this)[i].ToString();
+        }
+        return name;
+    }
+};
+}
+}
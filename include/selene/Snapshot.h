@@ -0,0 +1,244 @@
+#pragma once
+
+#include "LuaRef.h"
+#include <utility>
+
+extern "C" {
+#include <lua.h>
+#include <lauxlib.h>
+}
+
+namespace sel {
+/*
+ * Handle to a recorded state of the global table, see State::Snapshot.
+ * Only the most recent snapshot of a state can be restored. The handle
+ * must not outlive its State.
+ */
+class GlobalsSnapshot {
+private:
+    LuaRef _data;
+
+public:
+    GlobalsSnapshot() = default;
+    explicit GlobalsSnapshot(LuaRef data) : _data(std::move(data)) {}
+
+    GlobalsSnapshot(GlobalsSnapshot &&) = default;
+    GlobalsSnapshot &operator=(GlobalsSnapshot &&) = default;
+
+    void Push(lua_State *l) const {
+        _data.Push(l);
+    }
+};
+
+namespace detail {
+/*
+ * While a snapshot is active the global table itself only holds the
+ * globals written since. Everything else is read through __index from
+ * the base table, which holds the globals as of the snapshot. The first
+ * write to a base global moves its value into the saved table, so
+ * restoring only touches what was written:
+ *
+ *     data[1] base, data[2] saved, data[3] metatable of the global
+ *     table, data[4] copies of nested tables for deep snapshots
+ */
+enum {
+    _snapshot_base = 1,
+    _snapshot_saved,
+    _snapshot_meta,
+    _snapshot_deep
+};
+
+inline void *_active_snapshot_key() {
+    static char key;
+    return &key;
+}
+
+// __newindex of the global table. Upvalue 1 is base, upvalue 2 saved.
+inline int _snapshot_newindex(lua_State *l) {
+    lua_settop(l, 3);
+    lua_pushvalue(l, 2);
+    lua_rawget(l, lua_upvalueindex(1));
+    if (!lua_isnil(l, -1)) {
+        lua_pushvalue(l, 2);
+        lua_insert(l, -2);
+        lua_rawset(l, lua_upvalueindex(2));
+        lua_pushvalue(l, 2);
+        lua_pushnil(l);
+        lua_rawset(l, lua_upvalueindex(1));
+    } else {
+        lua_pop(l, 1);
+    }
+    lua_rawset(l, 1);
+    return 0;
+}
+
+// Copies all entries of the table at from into the table at to
+inline void _copy_entries(lua_State *l, int from, int to) {
+    from = lua_absindex(l, from);
+    to = lua_absindex(l, to);
+    lua_pushnil(l);
+    while (lua_next(l, from) != 0) {
+        lua_pushvalue(l, -2);
+        lua_insert(l, -2);
+        lua_rawset(l, to);
+    }
+}
+
+// Removes all entries of the table at index
+inline void _clear_entries(lua_State *l, int index) {
+    index = lua_absindex(l, index);
+    lua_pushnil(l);
+    while (lua_next(l, index) != 0) {
+        lua_pop(l, 1);
+        lua_pushvalue(l, -1);
+        lua_pushnil(l);
+        lua_rawset(l, index);
+    }
+}
+
+// Makes the table at index hold exactly the entries of the table at copy
+inline void _reset_entries(lua_State *l, int index, int copy) {
+    index = lua_absindex(l, index);
+    copy = lua_absindex(l, copy);
+    lua_pushnil(l);
+    while (lua_next(l, index) != 0) {
+        lua_pop(l, 1);
+        lua_pushvalue(l, -1);
+        lua_rawget(l, copy);
+        const bool added = lua_isnil(l, -1);
+        lua_pop(l, 1);
+        if (added) {
+            lua_pushvalue(l, -1);
+            lua_pushnil(l);
+            lua_rawset(l, index);
+        }
+    }
+    _copy_entries(l, copy, index);
+}
+
+// Records a copy of every table reachable from the table at base,
+// except the global table, in the table at deep.
+inline void _copy_nested_tables(lua_State *l, int base, int deep) {
+    base = lua_absindex(l, base);
+    deep = lua_absindex(l, deep);
+    // Tables left to visit, kept in a Lua array to avoid recursion
+    lua_newtable(l);
+    const int pending = lua_gettop(l);
+    int size = 0;
+    lua_pushvalue(l, base);
+    lua_rawseti(l, pending, ++size);
+    while (size > 0) {
+        lua_rawgeti(l, pending, size);
+        lua_pushnil(l);
+        lua_rawseti(l, pending, size--);
+        const int table = lua_gettop(l);
+        lua_pushnil(l);
+        while (lua_next(l, table) != 0) {
+            lua_pushglobaltable(l);
+            const bool skip = !lua_istable(l, -2) || lua_rawequal(l, -1, -2);
+            lua_pop(l, 1);
+            if (!skip) {
+                lua_pushvalue(l, -1);
+                lua_rawget(l, deep);
+                const bool visited = !lua_isnil(l, -1);
+                lua_pop(l, 1);
+                if (!visited) {
+                    lua_newtable(l);
+                    _copy_entries(l, -2, -1);
+                    lua_pushvalue(l, -2);
+                    lua_insert(l, -2);
+                    lua_rawset(l, deep);
+                    lua_pushvalue(l, -1);
+                    lua_rawseti(l, pending, ++size);
+                }
+            }
+            lua_pop(l, 1);
+        }
+        lua_pop(l, 1);
+    }
+    lua_pop(l, 1);
+}
+
+// Pushes the data table of a new snapshot of the global table
+inline void _take_snapshot(lua_State *l, bool deep) {
+    lua_createtable(l, 4, 0);
+    const int data = lua_gettop(l);
+    lua_pushglobaltable(l);
+    const int globals = lua_gettop(l);
+
+    lua_newtable(l);
+    const int base = lua_gettop(l);
+    lua_rawgetp(l, LUA_REGISTRYINDEX, _active_snapshot_key());
+    if (lua_istable(l, -1)) {
+        // Fold the globals seen through the previous snapshot
+        lua_rawgeti(l, -1, _snapshot_base);
+        _copy_entries(l, -1, base);
+        lua_pop(l, 1);
+    }
+    lua_pop(l, 1);
+    _copy_entries(l, globals, base);
+    _clear_entries(l, globals);
+    lua_pushvalue(l, base);
+    lua_rawseti(l, data, _snapshot_base);
+
+    lua_newtable(l);
+    const int saved = lua_gettop(l);
+    lua_pushvalue(l, saved);
+    lua_rawseti(l, data, _snapshot_saved);
+
+    lua_createtable(l, 0, 2);
+    lua_pushvalue(l, base);
+    lua_setfield(l, -2, "__index");
+    lua_pushvalue(l, base);
+    lua_pushvalue(l, saved);
+    lua_pushcclosure(l, &_snapshot_newindex, 2);
+    lua_setfield(l, -2, "__newindex");
+    lua_pushvalue(l, -1);
+    lua_setmetatable(l, globals);
+    lua_rawseti(l, data, _snapshot_meta);
+
+    if (deep) {
+        lua_newtable(l);
+        _copy_nested_tables(l, base, -1);
+        lua_rawseti(l, data, _snapshot_deep);
+    }
+
+    lua_settop(l, data);
+    lua_pushvalue(l, data);
+    lua_rawsetp(l, LUA_REGISTRYINDEX, _active_snapshot_key());
+}
+
+// Restores the snapshot whose data table is at index. Returns false
+// if it is not the active snapshot of the state.
+inline bool _restore_snapshot(lua_State *l, int data) {
+    data = lua_absindex(l, data);
+    const int top = lua_gettop(l);
+    lua_rawgetp(l, LUA_REGISTRYINDEX, _active_snapshot_key());
+    const bool active = lua_istable(l, -1) && lua_rawequal(l, -1, data);
+    lua_settop(l, top);
+    if (!active) return false;
+
+    lua_rawgeti(l, data, _snapshot_base);
+    lua_rawgeti(l, data, _snapshot_saved);
+    _copy_entries(l, -1, -2);
+    _clear_entries(l, -1);
+
+    lua_pushglobaltable(l);
+    _clear_entries(l, -1);
+    lua_rawgeti(l, data, _snapshot_meta);
+    lua_setmetatable(l, -2);
+
+    lua_rawgeti(l, data, _snapshot_deep);
+    if (lua_istable(l, -1)) {
+        const int deep = lua_gettop(l);
+        lua_pushnil(l);
+        while (lua_next(l, deep) != 0) {
+            _reset_entries(l, -2, -1);
+            lua_pop(l, 1);
+        }
+    }
+    lua_settop(l, top);
+    return true;
+}
+}
+}
@@ -1,56 +1,244 @@
 #pragma once
 
+#include "Allocator.h"
+#include "BoundSelector.h"
+#include "Bundle.h"
+#include "BytecodeCache.h"
+#include "CallBatch.h"
+#include "ChunkCache.h"
+#include <cstring>
 #include "ExceptionHandler.h"
+#include "GarbageCollector.h"
+#include "MappedFile.h"
 #include <iostream>
 #include <memory>
 #include <string>
 #include "Registry.h"
 #include "Selector.h"
+#include "Snapshot.h"
 #include <tuple>
 #include "util.h"
 #include <vector>
 
 namespace sel {
+/*
+ * What a State does with its lua_State on destruction.
+ *
+ * Collect: full collection, then lua_close (the default).
+ * Close: lua_close only, which runs all finalizers and frees every
+ *     object without the extra collection.
+ * FinalizeOwned: runs the finalizers of userdata created by Selene
+ *     (registered classes and stored exceptions) and releases the rest
+ *     of the memory in bulk with the allocator.
+ * Abandon: runs no finalizers and releases all memory in bulk.
+ *
+ * The last two skip lua_close, so they need an allocator that can
+ * release everything at once, such as PoolAllocator. Without one they
+ * behave like Close.
+ */
+enum class Teardown {
+    Collect,
+    Close,
+    FinalizeOwned,
+    Abandon
+};
+
 class State {
 private:
+    // Declared first so that it is destroyed after the lua_State
+    std::unique_ptr<Allocator> _allocator;
     lua_State *_l;
     bool _l_owner;
     std::unique_ptr<Registry> _registry;
     std::unique_ptr<ExceptionHandler> _exception_handler;
+    GarbageCollector _gc;
+    Teardown _teardown = Teardown::Collect;
+    BytecodeCache _bytecode_cache;
+    ChunkCache _chunk_cache;
+    std::vector<std::unique_ptr<Bundle>> _bundles;
+
+    // Reports a failed load to the exception handler
+    bool _check_loaded(int status, const std::string &name) {
+#if LUA_VERSION_NUM >= 502
+        auto const lua_ok = LUA_OK;
+#else
+        auto const lua_ok = 0;
+#endif
+        if (status != lua_ok) {
+            if (status == LUA_ERRSYNTAX) {
+                const char *msg = lua_tostring(_l, -1);
+                _exception_handler->Handle(status, msg ? msg : name + ": syntax error");
+            } else if (status == LUA_ERRFILE) {
+                const char *msg = lua_tostring(_l, -1);
+                _exception_handler->Handle(status, msg ? msg : name + ": file error");
+            }
+            return false;
+        }
+        return true;
+    }
+
+    // Runs the chunk loaded with the given status
+    bool _run_chunk(int status, const std::string &name) {
+        if (!_check_loaded(status, name)) {
+            return false;
+        }
+
+        status = detail::_pcall(_l, 0, LUA_MULTRET, 0);
+        if(status == 0) {
+            return true;
+        }
+
+        const char *msg = lua_tostring(_l, -1);
+        _exception_handler->Handle(status, msg ? msg : name + ": dofile failed");
+        return false;
+    }
+
+    // Loads a script like luaL_loadfile, but maps the file into memory
+    // and hands it to Lua in one piece
+    int _load_mapped(const std::string &file) {
+        MappedFile mapped(file);
+        if (!mapped.Valid()) {
+            // Reports the error the way luaL_loadfile does. It pushes the
+            // message unprotected, so it runs outside the memory limits.
+            return luaL_loadfile(_l, file.c_str());
+        }
+        const std::string chunk_name = "@" + file;
+        const std::size_t start = detail::_source_start(mapped.Data(), mapped.Size());
+        return detail::_load_buffer(_l, mapped.Data() + start, mapped.Size() - start,
+                                    chunk_name.c_str(), nullptr);
+    }
+
+    // Loads a script through the bytecode cache, compiling and storing
+    // it on a miss or when the cached entry cannot be loaded
+    int _load_cached(const std::string &file) {
+        MappedFile source(file);
+        if (!source.Valid()) {
+            return luaL_loadfile(_l, file.c_str());
+        }
+        const std::string chunk_name = "@" + file;
+        const std::string entry = _bytecode_cache.EntryPath(file, source.Data(), source.Size());
+        MappedFile bytecode(entry);
+        if (bytecode.Valid() && bytecode.Size() > 0) {
+            if (detail::_load_buffer(_l, bytecode.Data(), bytecode.Size(),
+                                     chunk_name.c_str(), "b") == 0) {
+                return 0;
+            }
+            lua_pop(_l, 1);
+        }
+        const std::size_t start = detail::_source_start(source.Data(), source.Size());
+        const int status = detail::_load_buffer(_l, source.Data() + start,
+                                                source.Size() - start,
+                                                chunk_name.c_str(), nullptr);
+        if (status == 0) {
+            // Not stripped, so that errors still report line numbers
+            _bytecode_cache.Write(entry, detail::_dump_function(_l, false));
+        }
+        return status;
+    }
+
+    bool _run_code(const std::string &key, const char *code) {
+        ResetStackOnScopeExit savedStack(_l);
+        int status = 0;
+        if (!_chunk_cache.Enabled() || !_chunk_cache.Push(_l, key)) {
+            // Loaded like luaL_loadstring, which names the chunk after its code
+            status = detail::_load_buffer(_l, code, std::strlen(code), code, nullptr);
+            if (status == 0 && _chunk_cache.Enabled()) {
+                _chunk_cache.Insert(_l, key);
+            }
+        }
+        if(status == 0) {
+            status = detail::_pcall(_l, 0, LUA_MULTRET, 0);
+        }
+        if(status) {
+            _exception_handler->Handle_top_of_stack(status, _l);
+            return false;
+        }
+        return true;
+    }
+
+    void _close() {
+        _chunk_cache.Clear();
+        const bool bulk = _allocator && _allocator->CanReleaseAll();
+        switch (_teardown) {
+        case Teardown::Collect:
+            ForceGC();
+            lua_close(_l);
+            break;
+        case Teardown::FinalizeOwned:
+            if (bulk) {
+                detail::_finalize_owned_userdata(_l);
+                break;
+            }
+            lua_close(_l);
+            break;
+        case Teardown::Abandon:
+            if (bulk) break;
+            lua_close(_l);
+            break;
+        default:
+            lua_close(_l);
+            break;
+        }
+    }
 
 public:
     State() : State(false) {}
-    State(bool should_open_libs) : _l(nullptr), _l_owner(true), _exception_handler(new ExceptionHandler) {
+    State(bool should_open_libs) : _l(nullptr), _l_owner(true), _exception_handler(new ExceptionHandler), _gc(nullptr) {
         _l = luaL_newstate();
         if (_l == nullptr) throw 0;
+        _gc.SetState(_l);
+        if (should_open_libs) luaL_openlibs(_l);
+        _registry.reset(new Registry(_l));
+        HandleExceptionsPrintingToStdOut();
+    }
+    // The state allocates all its memory through the given allocator
+    State(std::unique_ptr<Allocator> allocator, bool should_open_libs = false)
+        : _allocator(std::move(allocator)), _l(nullptr), _l_owner(true),
+          _exception_handler(new ExceptionHandler), _gc(nullptr) {
+        _l = lua_newstate(&Allocator::LuaAlloc, _allocator.get());
+        if (_l == nullptr) throw 0;
+        _gc.SetState(_l);
         if (should_open_libs) luaL_openlibs(_l);
         _registry.reset(new Registry(_l));
         HandleExceptionsPrintingToStdOut();
     }
-    State(lua_State *l) : _l(l), _l_owner(false), _exception_handler(new ExceptionHandler) {
+    State(lua_State *l) : _l(l), _l_owner(false), _exception_handler(new ExceptionHandler), _gc(l) {
         _registry.reset(new Registry(_l));
         HandleExceptionsPrintingToStdOut();
     }
     State(const State &other) = delete;
     State &operator=(const State &other) = delete;
     State(State &&other)
-        : _l(other._l),
+        : _allocator(std::move(other._allocator)),
+          _l(other._l),
           _l_owner(other._l_owner),
-          _registry(std::move(other._registry)) {
+          _registry(std::move(other._registry)),
+          _exception_handler(std::move(other._exception_handler)),
+          _gc(other._gc),
+          _teardown(other._teardown),
+          _bytecode_cache(std::move(other._bytecode_cache)),
+          _chunk_cache(std::move(other._chunk_cache)),
+          _bundles(std::move(other._bundles)) {
         other._l = nullptr;
     }
     State &operator=(State &&other) {
         if (&other == this) return *this;
+        _allocator = std::move(other._allocator);
         _l = other._l;
         _l_owner = other._l_owner;
         _registry = std::move(other._registry);
+        _exception_handler = std::move(other._exception_handler);
+        _gc = other._gc;
+        _teardown = other._teardown;
+        _bytecode_cache = std::move(other._bytecode_cache);
+        _chunk_cache = std::move(other._chunk_cache);
+        _bundles = std::move(other._bundles);
         other._l = nullptr;
         return *this;
     }
     ~State() {
         if (_l != nullptr && _l_owner) {
-            ForceGC();
-            lua_close(_l);
+            _close();
         }
         _l = nullptr;
     }
@@ -61,31 +249,54 @@ public:
 
     bool Load(const std::string &file) {
         ResetStackOnScopeExit savedStack(_l);
-        int status = luaL_loadfile(_l, file.c_str());
-#if LUA_VERSION_NUM >= 502
-        auto const lua_ok = LUA_OK;
-#else
-        auto const lua_ok = 0;
-#endif
-        if (status != lua_ok) {
-            if (status == LUA_ERRSYNTAX) {
-                const char *msg = lua_tostring(_l, -1);
-                _exception_handler->Handle(status, msg ? msg : file + ": syntax error");
-            } else if (status == LUA_ERRFILE) {
-                const char *msg = lua_tostring(_l, -1);
-                _exception_handler->Handle(status, msg ? msg : file + ": file error");
-            }
-            return false;
+        if (_bytecode_cache.Enabled()) {
+            return _run_chunk(_load_cached(file), file);
         }
+        return _run_chunk(_load_mapped(file), file);
+    }
 
-        status = lua_pcall(_l, 0, LUA_MULTRET, 0);
-        if(status == lua_ok) {
-            return true;
+    // Compiles a script without running it. Returns its bytecode,
+    // stripped of debug information, or an empty string if it cannot be
+    // loaded.
+    std::string Compile(const std::string &file) {
+        ResetStackOnScopeExit savedStack(_l);
+        const int status = _load_mapped(file);
+        if (!_check_loaded(status, file)) {
+            return std::string{};
         }
+        return detail::_dump_function(_l, true);
+    }
 
-        const char *msg = lua_tostring(_l, -1);
-        _exception_handler->Handle(status, msg ? msg : file + ": dofile failed");
-        return false;
+    // Runs bytecode produced by Compile. Source text is rejected.
+    bool LoadBytecode(const std::string &bytecode,
+                      const std::string &name = "=bytecode") {
+        ResetStackOnScopeExit savedStack(_l);
+        const int status = detail::_load_buffer(_l, bytecode.data(), bytecode.size(),
+                                                name.c_str(), "b");
+        return _run_chunk(status, name);
+    }
+
+    // Makes Load keep compiled scripts in directory and reuse them
+    // while the script is unchanged. An empty directory disables it.
+    void EnableBytecodeCache(const std::string &directory) {
+        _bytecode_cache = BytecodeCache{directory};
+    }
+
+    // Makes require find the modules of a bundle written by selene_pack
+    // before looking on package.path. Needs the package library.
+    bool LoadBundle(const std::string &path) {
+        ResetStackOnScopeExit savedStack(_l);
+        std::unique_ptr<Bundle> bundle{new Bundle(path)};
+        if (!bundle->Valid()) {
+            _exception_handler->Handle(LUA_ERRFILE, path + ": not a valid bundle");
+            return false;
+        }
+        if (!detail::_add_bundle_searcher(_l, bundle.get())) {
+            _exception_handler->Handle(LUA_ERRFILE, path + ": package.searchers not found");
+            return false;
+        }
+        _bundles.push_back(std::move(bundle));
+        return true;
     }
 
     void OpenLib(const std::string& modname, lua_CFunction openf) {
@@ -100,29 +311,112 @@ public:
     }
 
     void HandleExceptionsPrintingToStdOut() {
-        *_exception_handler = ExceptionHandler([](int, std::string msg, std::exception_ptr){_print(msg);});
+        _exception_handler->SetHandler([](int, std::string msg, std::exception_ptr){_print(msg);});
     }
 
     void HandleExceptionsWith(ExceptionHandler::function handler) {
-        *_exception_handler = ExceptionHandler(std::move(handler));
+        _exception_handler->SetHandler(std::move(handler));
     }
 
 public:
-    Selector operator[](const char *name) const {
-        return Selector(_l, *_registry, *_exception_handler, name);
+    // Names given as const char arrays, such as string literals, are
+    // not copied and must outlive the selector
+    template <std::size_t N>
+    Selector operator[](const char (&name)[N]) const {
+        return Selector(_l, *_registry, *_exception_handler,
+                        detail::SelectorKey::Literal(name));
+    }
+    template <std::size_t N>
+    Selector operator[](char (&name)[N]) const {
+        return Selector(_l, *_registry, *_exception_handler,
+                        detail::SelectorKey{static_cast<const char *>(name)});
+    }
+    template <typename T, typename = detail::_enable_if_c_string<T>>
+    Selector operator[](T name) const {
+        return Selector(_l, *_registry, *_exception_handler,
+                        detail::SelectorKey{static_cast<const char *>(name)});
+    }
+
+    // Pins the message handler on the stack until the returned object
+    // goes out of scope, so that a series of calls into Lua does not
+    // set up a handler for every single call.
+    CallBatch BatchCalls() {
+        return CallBatch(_l, *_exception_handler);
     }
 
     bool operator()(const char *code) {
-        ResetStackOnScopeExit savedStack(_l);
-        int status = luaL_dostring(_l, code);
-        if(status) {
-            _exception_handler->Handle_top_of_stack(status, _l);
-            return false;
-        }
-        return true;
+        return _run_code(_chunk_cache.Enabled() ? code : std::string{}, code);
+    }
+
+    // Like operator(), but cached under id instead of the code itself,
+    // so a hit does not need to hash long code
+    bool Run(const std::string &id, const char *code) {
+        return _run_code(id, code);
+    }
+
+    // Keeps up to capacity compiled snippets run through operator() or
+    // Run for reuse, evicting the least recently used. 0 disables it.
+    void EnableChunkCache(std::size_t capacity) {
+        _chunk_cache.SetCapacity(capacity);
     }
+
+    const ChunkCacheStats &ChunkStats() const {
+        return _chunk_cache.Stats();
+    }
+
+    // The allocator passed to the constructor, nullptr if there is none
+    Allocator *GetAllocator() const {
+        return _allocator.get();
+    }
+
+    // Memory counters of the allocator passed to the constructor. States
+    // using the default allocator only report the bytes in use.
+    AllocatorStats MemoryStats() const {
+        if (_allocator) return _allocator->Stats();
+        AllocatorStats stats;
+        stats.bytes_in_use = static_cast<std::size_t>(lua_gc(_l, LUA_GCCOUNT, 0)) * 1024
+            + static_cast<std::size_t>(lua_gc(_l, LUA_GCCOUNTB, 0));
+        stats.peak_bytes = stats.bytes_in_use;
+        return stats;
+    }
+
     void ForceGC() {
-        lua_gc(_l, LUA_GCCOLLECT, 0);
+        _gc.Collect();
+    }
+
+    /*
+     * Records the global table so that Restore can bring it back to
+     * this point. Only the globals written after the snapshot are
+     * touched by a restore. With deep, tables reachable from globals are
+     * recorded too and their contents reset on restore, which costs
+     * time proportional to their size.
+     *
+     * While a snapshot is active the global table only holds the
+     * globals written since, and reads fall back to the recorded ones
+     * through its metatable. Any existing metatable of the global table
+     * is replaced, and pairs or rawget on it only see the new globals.
+     */
+    GlobalsSnapshot Snapshot(bool deep = false) {
+        detail::_take_snapshot(_l, deep);
+        return GlobalsSnapshot{LuaRef(_l, luaL_ref(_l, LUA_REGISTRYINDEX))};
+    }
+
+    // Returns false if the snapshot is not the latest one of this state
+    bool Restore(const GlobalsSnapshot &snapshot) {
+        ResetStackOnScopeExit save(_l);
+        snapshot.Push(_l);
+        if (!lua_istable(_l, -1)) return false;
+        return detail::_restore_snapshot(_l, -1);
+    }
+
+    // Selects how the state is torn down, see Teardown
+    void SetTeardown(Teardown mode) {
+        _teardown = mode;
+    }
+
+    // Collector mode, tuning, time-budgeted steps and statistics
+    GarbageCollector &GC() {
+        return _gc;
     }
 
     void InteractiveDebug() {
@@ -130,6 +424,7 @@ public:
     }
 
     friend std::ostream &operator<<(std::ostream &os, const State &state);
+    friend class StatePool;
 };
 
 inline std::ostream &operator<<(std::ostream &os, const State &state) {
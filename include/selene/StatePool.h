@@ -0,0 +1,155 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include "State.h"
+#include <utility>
+#include <vector>
+
+namespace sel {
+/*
+ * Keeps initialized states around for reuse. Every state is created by
+ * the factory and set up once by the initializer (opening libraries,
+ * registering classes and functions, loading scripts), after which its
+ * globals are recorded. When a lease ends, the globals are restored to
+ * that snapshot (see State::Snapshot), the exception handler, teardown
+ * mode and chunk cache are reset to how the initializer left them, and
+ * the state goes back to the pool. A state whose snapshot can no longer
+ * be restored, e.g. because the lessee took its own, is replaced.
+ *
+ * Functions and classes registered after initialization stay alive on
+ * the C++ side until the state is destroyed, so register them in the
+ * initializer. The pool must outlive all leases.
+ */
+class StatePool {
+public:
+    using Initializer = std::function<void(State &)>;
+    using Factory = std::function<std::unique_ptr<State>()>;
+
+    struct Pooled {
+        std::unique_ptr<State> state;
+        // Settings left by the initializer
+        ExceptionHandler::function handler;
+        Teardown teardown;
+        std::size_t chunk_cache_capacity;
+        // Declared last so it is released before its State
+        GlobalsSnapshot snapshot;
+    };
+
+    class Lease {
+    private:
+        StatePool *_pool;
+        Pooled _pooled;
+
+    public:
+        Lease(StatePool &pool, Pooled pooled)
+            : _pool(&pool), _pooled(std::move(pooled)) {}
+
+        Lease(Lease &&other) = default;
+        Lease &operator=(Lease &&other) {
+            if (&other == this) return *this;
+            _return();
+            _pool = other._pool;
+            _pooled = std::move(other._pooled);
+            return *this;
+        }
+
+        Lease(const Lease &) = delete;
+        Lease &operator=(const Lease &) = delete;
+
+        ~Lease() {
+            _return();
+        }
+
+        State &operator*() const {
+            return *_pooled.state;
+        }
+
+        State *operator->() const {
+            return _pooled.state.get();
+        }
+
+    private:
+        void _return() {
+            if (_pooled.state) _pool->_release(std::move(_pooled));
+        }
+    };
+
+private:
+    Factory _factory;
+    Initializer _init;
+    std::vector<Pooled> _idle;
+    std::mutex _mutex;
+
+    Pooled _create() {
+        Pooled pooled;
+        pooled.state = _factory();
+        State &state = *pooled.state;
+        _init(state);
+        lua_settop(state._l, 0);
+        pooled.handler = state._exception_handler->Handler();
+        pooled.teardown = state._teardown;
+        pooled.chunk_cache_capacity = state._chunk_cache.Capacity();
+        pooled.snapshot = state.Snapshot();
+        return pooled;
+    }
+
+    void _release(Pooled pooled) {
+        State &state = *pooled.state;
+        lua_settop(state._l, 0);
+        if (!state.Restore(pooled.snapshot)) {
+            // The snapshot refers into the dirty state, so it goes first
+            pooled.snapshot = GlobalsSnapshot{};
+            pooled.state.reset();
+            pooled = _create();
+        } else {
+            state._exception_handler->SetHandler(pooled.handler);
+            state.SetTeardown(pooled.teardown);
+            state._chunk_cache.Clear();
+            state._chunk_cache.SetCapacity(pooled.chunk_cache_capacity);
+        }
+        std::lock_guard<std::mutex> lock(_mutex);
+        _idle.push_back(std::move(pooled));
+    }
+
+    static std::unique_ptr<State> _default_factory() {
+        return std::unique_ptr<State>(new State{true});
+    }
+
+public:
+    // States are created with the standard libraries opened
+    explicit StatePool(Initializer init, std::size_t prewarm = 0)
+        : StatePool(&_default_factory, std::move(init), prewarm) {}
+
+    // States are created by factory, e.g. to give them an Allocator and
+    // memory limits
+    StatePool(Factory factory, Initializer init, std::size_t prewarm = 0)
+        : _factory(std::move(factory)), _init(std::move(init)) {
+        for (std::size_t i = 0; i < prewarm; ++i) {
+            _idle.push_back(_create());
+        }
+    }
+
+    StatePool(const StatePool &) = delete;
+    StatePool &operator=(const StatePool &) = delete;
+
+    // Hands out an idle state, or initializes a new one if none is left
+    Lease Acquire() {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (!_idle.empty()) {
+                Pooled pooled = std::move(_idle.back());
+                _idle.pop_back();
+                return Lease(*this, std::move(pooled));
+            }
+        }
+        return Lease(*this, _create());
+    }
+
+    std::size_t IdleCount() {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _idle.size();
+    }
+};
+}
@@ -0,0 +1,129 @@
+#pragma once
+
+#include "BaseFun.h"
+#include <cstring>
+#include "primitives.h"
+
+namespace sel {
+/*
+ * Names a free function or member function known at compile time.
+ * Registering it generates a dedicated lua_CFunction that reads the
+ * arguments straight from the Lua stack and calls the function
+ * directly, without a BaseFun object or std::function in between.
+ *
+ *     state["add"] = SEL_FUN(&add);
+ *     state["Foo"].SetClass<Foo>("get", SEL_FUN(&Foo::get));
+ */
+template <typename F, F f>
+struct StaticFun {};
+
+#define SEL_FUN(f) ::sel::StaticFun<decltype(f), f>{}
+
+namespace detail {
+
+// Calls fun with the arguments starting at stack index First and pushes
+// the result. Returns the number of values pushed.
+template <int First, typename Ret, typename... Args, std::size_t... N>
+inline int _apply_fun(lua_State *l, Ret (*fun)(Args...), _indices<N...>) {
+    _push(l, fun(_check_get(_id<decay_primitive<Args>>{}, l, First + N)...));
+    return _arity<Ret>::value;
+}
+
+template <int First, typename... Args, std::size_t... N>
+inline int _apply_fun(lua_State *l, void (*fun)(Args...), _indices<N...>) {
+    (void)l; // unused when there are no arguments
+    fun(_check_get(_id<decay_primitive<Args>>{}, l, First + N)...);
+    return 0;
+}
+
+// Member functions take the object from stack index 1
+template <typename T, typename Ret, typename... Args, std::size_t... N>
+inline int _apply_method(lua_State *l, Ret (T::*fun)(Args...), _indices<N...>) {
+    T &self = _check_get(_id<T&>{}, l, 1);
+    _push(l, (self.*fun)(_check_get(_id<decay_primitive<Args>>{}, l, N + 2)...));
+    return _arity<Ret>::value;
+}
+
+template <typename T, typename... Args, std::size_t... N>
+inline int _apply_method(lua_State *l, void (T::*fun)(Args...), _indices<N...>) {
+    T &self = _check_get(_id<T&>{}, l, 1);
+    (self.*fun)(_check_get(_id<decay_primitive<Args>>{}, l, N + 2)...);
+    return 0;
+}
+
+template <typename T, typename Ret, typename... Args, std::size_t... N>
+inline int _apply_method(lua_State *l, Ret (T::*fun)(Args...) const, _indices<N...>) {
+    const T &self = _check_get(_id<T&>{}, l, 1);
+    _push(l, (self.*fun)(_check_get(_id<decay_primitive<Args>>{}, l, N + 2)...));
+    return _arity<Ret>::value;
+}
+
+template <typename T, typename... Args, std::size_t... N>
+inline int _apply_method(lua_State *l, void (T::*fun)(Args...) const, _indices<N...>) {
+    const T &self = _check_get(_id<T&>{}, l, 1);
+    (self.*fun)(_check_get(_id<decay_primitive<Args>>{}, l, N + 2)...);
+    return 0;
+}
+
+template <typename F, F f>
+struct _static_fun;
+
+template <typename Ret, typename... Args, Ret (*f)(Args...)>
+struct _static_fun<Ret (*)(Args...), f> {
+    static int apply(lua_State *l) {
+        return _apply_fun<1>(l, f, typename _indices_builder<sizeof...(Args)>::type());
+    }
+
+    static int call(lua_State *l) {
+        return _dispatch(l, &apply);
+    }
+};
+
+template <typename T, typename Ret, typename... Args, Ret (T::*f)(Args...)>
+struct _static_fun<Ret (T::*)(Args...), f> {
+    static int apply(lua_State *l) {
+        return _apply_method(l, f, typename _indices_builder<sizeof...(Args)>::type());
+    }
+
+    static int call(lua_State *l) {
+        return _dispatch(l, &apply);
+    }
+};
+
+template <typename T, typename Ret, typename... Args, Ret (T::*f)(Args...) const>
+struct _static_fun<Ret (T::*)(Args...) const, f> {
+    static int apply(lua_State *l) {
+        return _apply_method(l, f, typename _indices_builder<sizeof...(Args)>::type());
+    }
+
+    static int call(lua_State *l) {
+        return _dispatch(l, &apply);
+    }
+};
+
+// Function pointers only known at runtime, including captureless
+// lambdas, are kept in a userdata upvalue of a closure generated for
+// their signature.
+template <typename Ret, typename... Args>
+struct _fun_ptr_dispatcher {
+    using fun_type = Ret (*)(Args...);
+
+    static int apply(lua_State *l) {
+        fun_type fun;
+        std::memcpy(&fun, lua_touserdata(l, lua_upvalueindex(1)), sizeof(fun));
+        return _apply_fun<1>(l, fun, typename _indices_builder<sizeof...(Args)>::type());
+    }
+
+    static int call(lua_State *l) {
+        return _dispatch(l, &apply);
+    }
+};
+
+template <typename Ret, typename... Args>
+inline void _push_fun_ptr(lua_State *l, Ret (*fun)(Args...)) {
+    void *addr = lua_newuserdata(l, sizeof(fun));
+    std::memcpy(addr, &fun, sizeof(fun));
+    lua_pushcclosure(l, &_fun_ptr_dispatcher<Ret, Args...>::call, 1);
+}
+}
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <ostream>
+#include <string>
+
+namespace sel {
+/*
+ * Non-owning view of a string, for C++11 code that has no
+ * std::string_view. As a parameter of a function called from Lua it
+ * borrows the memory of the Lua string, which is only valid until the
+ * function returns. Copy it into a std::string to keep it longer.
+ */
+class string_view {
+private:
+    const char *_data;
+    std::size_t _size;
+
+public:
+    using const_iterator = const char *;
+
+    string_view() : _data(""), _size(0) {}
+    string_view(const char *data, std::size_t size) : _data(data), _size(size) {}
+    string_view(const char *s) : _data(s), _size(std::strlen(s)) {}
+    string_view(const std::string &s) : _data(s.data()), _size(s.size()) {}
+
+    const char *data() const {
+        return _data;
+    }
+
+    std::size_t size() const {
+        return _size;
+    }
+
+    std::size_t length() const {
+        return _size;
+    }
+
+    bool empty() const {
+        return _size == 0;
+    }
+
+    const_iterator begin() const {
+        return _data;
+    }
+
+    const_iterator end() const {
+        return _data + _size;
+    }
+
+    char operator[](std::size_t i) const {
+        return _data[i];
+    }
+
+    std::string str() const {
+        return std::string{_data, _size};
+    }
+
+    explicit operator std::string() const {
+        return str();
+    }
+
+    friend bool operator==(string_view a, string_view b) {
+        return a._size == b._size && std::equal(a.begin(), a.end(), b.begin());
+    }
+
+    friend bool operator!=(string_view a, string_view b) {
+        return !(a == b);
+    }
+
+    friend std::ostream &operator<<(std::ostream &os, string_view s) {
+        return os.write(s._data, s._size);
+    }
+};
+}
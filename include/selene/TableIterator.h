@@ -0,0 +1,137 @@
+#pragma once
+
+#include <cstddef>
+#include "primitives.h"
+
+extern "C" {
+#include <lua.h>
+}
+
+namespace sel {
+/*
+ * The entry a TableIterator currently points at. Its key and value sit
+ * on the stack until the iterator is advanced.
+ */
+class TableEntry {
+private:
+    lua_State *_state;
+    // Stack index of the key, the value is right above it
+    int _key;
+
+public:
+    TableEntry(lua_State *l, int key) : _state(l), _key(key) {}
+
+    // Number keys are converted from a copy, since converting them to a
+    // string in place would break lua_next. The copy stays on the stack
+    // until the iterator is advanced, so views of keys stay valid as
+    // long as the entry does.
+    template <typename K>
+    K Key() const {
+        if (lua_type(_state, _key) != LUA_TNUMBER) {
+            return detail::_get(detail::_id<K>{}, _state, _key);
+        }
+        lua_pushvalue(_state, _key);
+        return detail::_get(detail::_id<K>{}, _state, -1);
+    }
+
+    template <typename V>
+    V Value() const {
+        return detail::_get(detail::_id<V>{}, _state, _key + 1);
+    }
+};
+
+// Input iterator over the entries of a table, using lua_next
+class TableIterator {
+private:
+    lua_State *_state;
+    int _table;
+    int _key;
+    bool _end;
+
+    void _next() {
+        if (lua_next(_state, _table) == 0) {
+            _end = true;
+        } else {
+            _key = lua_gettop(_state) - 1;
+        }
+    }
+
+public:
+    TableIterator() : _state(nullptr), _table(0), _key(0), _end(true) {}
+    TableIterator(lua_State *l, int table)
+        : _state(l), _table(table), _key(0), _end(false) {
+        lua_pushnil(l);
+        _next();
+    }
+
+    TableEntry operator*() const {
+        return TableEntry{_state, _key};
+    }
+
+    // Drops the value and any key copies, leaving the key for lua_next
+    TableIterator &operator++() {
+        lua_settop(_state, _key);
+        _next();
+        return *this;
+    }
+
+    // Iterators are only compared against the end
+    bool operator==(const TableIterator &other) const {
+        return _end == other._end;
+    }
+
+    bool operator!=(const TableIterator &other) const {
+        return _end != other._end;
+    }
+};
+
+/*
+ * Keeps a table on the Lua stack for the lifetime of the object, so
+ * that it can be walked without looking it up again. Everything pushed
+ * above the table is removed on destruction, so ranges must be
+ * destroyed in the reverse order of their creation. Fields must not be
+ * added to the table while walking it. Only one walk at a time is
+ * supported.
+ */
+class TableRange {
+private:
+    lua_State *_state;
+    int _base;
+    int _table;
+
+public:
+    // The table is at index table, and everything above base is popped
+    // on destruction
+    TableRange(lua_State *l, int base, int table)
+        : _state(l), _base(base), _table(table) {}
+
+    TableRange(const TableRange &) = delete;
+    TableRange &operator=(const TableRange &) = delete;
+
+    TableRange(TableRange &&other)
+        : _state(other._state), _base(other._base), _table(other._table) {
+        other._state = nullptr;
+    }
+
+    TableRange &operator=(TableRange &&) = delete;
+
+    ~TableRange() {
+        if (_state != nullptr) lua_settop(_state, _base);
+    }
+
+    TableIterator begin() {
+        lua_settop(_state, _table);
+        if (!lua_istable(_state, _table)) return TableIterator{};
+        return TableIterator{_state, _table};
+    }
+
+    TableIterator end() const {
+        return TableIterator{};
+    }
+
+    // Length of the array part, as lua_rawlen reports it
+    std::size_t Size() const {
+        return lua_istable(_state, _table) ? lua_rawlen(_state, _table) : 0;
+    }
+};
+}
@@ -21,13 +21,36 @@ struct function_base {
     function_base(int ref, lua_State *state)
         : _ref(state, ref), _state(state), _exception_handler(nullptr) {}
 
+    function_base(const function_base &other)
+        : _ref(other._ref.Copy()), _state(other._state),
+          _exception_handler(other._exception_handler) {}
+
+    function_base(function_base &&) = default;
+
+    function_base & operator=(const function_base &other) {
+        _ref = other._ref.Copy();
+        _state = other._state;
+        _exception_handler = other._exception_handler;
+        return *this;
+    }
+
+    function_base & operator=(function_base &&) = default;
+
     void _enable_exception_handler(ExceptionHandler *exception_handler) {
         _exception_handler = exception_handler;
     }
 
+    // Index of the message handler for a call. A handler pinned by a
+    // CallBatch is reused, otherwise one is pushed.
+    int use_error_handler() const {
+        return UseErrorHandler(
+            _state,
+            _exception_handler ? _exception_handler->MessageHandlerIndex() : 0);
+    }
+
     void protected_call(int const num_args, int const num_ret,
                         int const handler_index) {
-        const auto status = lua_pcall(_state, num_args, num_ret, handler_index);
+        const auto status = detail::_pcall(_state, num_args, num_ret, handler_index);
 
         if (status != LUA_OK && _exception_handler) {
             _exception_handler->Handle_top_of_stack(status, _state);
@@ -49,13 +72,15 @@ class function {};
 template <typename R, typename... Args>
 class function<R(Args...)> : detail::function_base {
     friend class Selector;
+    static_assert(!detail::_is_string_view<R>::value,
+                  "Results cannot be string views; use std::string");
 public:
     using function_base::function_base;
 
     R operator()(Args... args) {
         ResetStackOnScopeExit save(_state);
 
-        int handler_index = SetErrorHandler(_state);
+        int handler_index = use_error_handler();
         _ref.Push(_state);
         detail::_push_n(_state, std::forward<Args>(args)...);
         constexpr int num_args = sizeof...(Args);
@@ -77,7 +102,7 @@ public:
     void operator()(Args... args) {
         ResetStackOnScopeExit save(_state);
 
-        int handler_index = SetErrorHandler(_state);
+        int handler_index = use_error_handler();
         _ref.Push(_state);
         detail::_push_n(_state, std::forward<Args>(args)...);
         constexpr int num_args = sizeof...(Args);
@@ -98,7 +123,8 @@ public:
     std::tuple<R...> operator()(Args... args) {
         ResetStackOnScopeExit save(_state);
 
-        int handler_index = SetErrorHandler(_state);
+        int handler_index = use_error_handler();
+        int const first_result = lua_gettop(_state) + 1;
         _ref.Push(_state);
         detail::_push_n(_state, std::forward<Args>(args)...);
         constexpr int num_args = sizeof...(Args);
@@ -106,8 +132,7 @@ public:
 
         protected_call(num_args, num_ret, handler_index);
 
-        lua_remove(_state, handler_index);
-        return detail::_get_n<R...>(_state);
+        return detail::_call_results<std::tuple<R...>>::get(_state, first_result);
     }
 
     using function_base::Push;
@@ -1,10 +1,22 @@
 #pragma once
 
+#include <array>
+#include "ArrayView.h"
 #include "ExceptionTypes.h"
+#include "Fields.h"
+#include <map>
 #include <string>
+#include "StringView.h"
 #include "traits.h"
 #include <type_traits>
+#include <unordered_map>
 #include "MetatableRegistry.h"
+#include "OwnedUserdata.h"
+#include <vector>
+
+#if __cplusplus >= 201703L
+#include <string_view>
+#endif
 
 extern "C" {
 #include <lua.h>
@@ -20,9 +32,10 @@ namespace sel {
 
 namespace detail {
 
+// Structs described with SEL_FIELDS are passed by value like primitives
 template <typename T>
 struct is_primitive {
-    static constexpr bool value = false;
+    static constexpr bool value = _has_fields<T>::value;
 };
 template <>
 struct is_primitive<int> {
@@ -44,6 +57,41 @@ template <>
 struct is_primitive<std::string> {
     static constexpr bool value = true;
 };
+template <>
+struct is_primitive<sel::string_view> {
+    static constexpr bool value = true;
+};
+template <>
+struct is_primitive<const char *> {
+    static constexpr bool value = true;
+};
+#if __cplusplus >= 201703L
+template <>
+struct is_primitive<std::string_view> {
+    static constexpr bool value = true;
+};
+#endif
+
+template <typename T>
+struct is_primitive<std::vector<T>> {
+    static constexpr bool value = true;
+};
+template <typename T, std::size_t N>
+struct is_primitive<std::array<T, N>> {
+    static constexpr bool value = true;
+};
+template <typename T>
+struct is_primitive<sel::ArrayView<T>> {
+    static constexpr bool value = true;
+};
+template <typename K, typename V, typename C, typename A>
+struct is_primitive<std::map<K, V, C, A>> {
+    static constexpr bool value = true;
+};
+template <typename K, typename V, typename H, typename E, typename A>
+struct is_primitive<std::unordered_map<K, V, H, E, A>> {
+    static constexpr bool value = true;
+};
 
 template<typename T>
 using decay_primitive =
@@ -53,6 +101,61 @@ using decay_primitive =
         T
     >::type;
 
+// Sequences are converted to and from tables, see the end of this file
+template <typename T>
+std::vector<T> _get(_id<std::vector<T>>, lua_State *l, const int index);
+template <typename T, std::size_t N>
+std::array<T, N> _get(_id<std::array<T, N>>, lua_State *l, const int index);
+template <typename T>
+ArrayView<T> _get(_id<ArrayView<T>>, lua_State *l, const int index);
+template <typename T>
+std::vector<T> _check_get(_id<std::vector<T>>, lua_State *l, const int index);
+template <typename T, std::size_t N>
+std::array<T, N> _check_get(_id<std::array<T, N>>, lua_State *l, const int index);
+template <typename T>
+ArrayView<T> _check_get(_id<ArrayView<T>>, lua_State *l, const int index);
+template <typename T>
+void _push(lua_State *l, const std::vector<T> &values);
+template <typename T, std::size_t N>
+void _push(lua_State *l, const std::array<T, N> &values);
+template <typename T>
+void _push(lua_State *l, ArrayView<T> view);
+
+// Associative containers and vectors of pairs are converted to and from
+// tables with arbitrary keys
+template <typename K, typename V, typename C, typename A>
+std::map<K, V, C, A> _get(_id<std::map<K, V, C, A>>, lua_State *l, const int index);
+template <typename K, typename V, typename H, typename E, typename A>
+std::unordered_map<K, V, H, E, A> _get(_id<std::unordered_map<K, V, H, E, A>>,
+                                       lua_State *l, const int index);
+template <typename K, typename V>
+std::vector<std::pair<K, V>> _get(_id<std::vector<std::pair<K, V>>>, lua_State *l, const int index);
+template <typename K, typename V, typename C, typename A>
+std::map<K, V, C, A> _check_get(_id<std::map<K, V, C, A>>, lua_State *l, const int index);
+template <typename K, typename V, typename H, typename E, typename A>
+std::unordered_map<K, V, H, E, A> _check_get(_id<std::unordered_map<K, V, H, E, A>>,
+                                             lua_State *l, const int index);
+template <typename K, typename V>
+std::vector<std::pair<K, V>> _check_get(_id<std::vector<std::pair<K, V>>>,
+                                        lua_State *l, const int index);
+template <typename K, typename V, typename C, typename A>
+void _push(lua_State *l, const std::map<K, V, C, A> &entries);
+template <typename K, typename V, typename H, typename E, typename A>
+void _push(lua_State *l, const std::unordered_map<K, V, H, E, A> &entries);
+template <typename K, typename V>
+void _push(lua_State *l, const std::vector<std::pair<K, V>> &entries);
+
+// Structs described with SEL_FIELDS are converted to and from tables
+template <typename T>
+typename std::enable_if<_has_fields<T>::value, T>::type
+_get(_id<T>, lua_State *l, const int index);
+template <typename T>
+typename std::enable_if<_has_fields<T>::value, T>::type
+_check_get(_id<T>, lua_State *l, const int index);
+template <typename T>
+typename std::enable_if<_has_fields<T>::value>::type
+_push(lua_State *l, const T &value);
+
 /* getters */
 template <typename T>
 inline T* _get(_id<T*>, lua_State *l, const int index) {
@@ -112,6 +215,25 @@ inline std::string _get(_id<std::string>, lua_State *l, const int index) {
     return std::string{buff, size};
 }
 
+// Views and C strings borrow the memory of the Lua string at index, so
+// they are only valid while the value stays on the stack.
+inline sel::string_view _get(_id<sel::string_view>, lua_State *l, const int index) {
+    size_t size = 0;
+    const char *buff = lua_tolstring(l, index, &size);
+    return buff == nullptr ? sel::string_view{} : sel::string_view{buff, size};
+}
+
+inline const char *_get(_id<const char *>, lua_State *l, const int index) {
+    return lua_tostring(l, index);
+}
+
+#if __cplusplus >= 201703L
+inline std::string_view _get(_id<std::string_view>, lua_State *l, const int index) {
+    const sel::string_view view = _get(_id<sel::string_view>{}, l, index);
+    return std::string_view{view.data(), view.size()};
+}
+#endif
+
 using _lua_check_get = void (*)(lua_State *l, int index);
 // Throw this on conversion errors to prevent long jumps caused in Lua from
 // bypassing destructors. The outermost function can then call checkd_get(index)
@@ -232,6 +354,29 @@ inline std::string _check_get(_id<std::string>, lua_State *l, const int index) {
     return std::string{buff, size};
 }
 
+inline sel::string_view _check_get(_id<sel::string_view>, lua_State *l, const int index) {
+    size_t size = 0;
+    char const * buff = lua_tolstring(l, index, &size);
+    if(buff == nullptr) {
+        throw GetParameterFromLuaTypeError{
+            [](lua_State *l, int index){luaL_checkstring(l, index);},
+            index
+        };
+    }
+    return sel::string_view{buff, size};
+}
+
+inline const char *_check_get(_id<const char *>, lua_State *l, const int index) {
+    return _check_get(_id<sel::string_view>{}, l, index).data();
+}
+
+#if __cplusplus >= 201703L
+inline std::string_view _check_get(_id<std::string_view>, lua_State *l, const int index) {
+    const sel::string_view view = _check_get(_id<sel::string_view>{}, l, index);
+    return std::string_view{view.data(), view.size()};
+}
+#endif
+
 // Worker type-trait struct to _get_n
 // Getting multiple elements returns a tuple
 template <typename... Ts>
@@ -270,6 +415,63 @@ typename _get_n_impl<T...>::type _get_n(lua_State *l) {
     return _get_n_impl<T...>::apply(l);
 }
 
+// Views of a Lua string are only valid while the string is on the
+// stack, so they cannot be returned once the stack is reset
+template <typename... T>
+struct _has_string_view : std::false_type {};
+
+template <typename T>
+struct _is_string_view : std::false_type {};
+template <>
+struct _is_string_view<sel::string_view> : std::true_type {};
+template <>
+struct _is_string_view<const char *> : std::true_type {};
+#if __cplusplus >= 201703L
+template <>
+struct _is_string_view<std::string_view> : std::true_type {};
+#endif
+template <typename... T>
+struct _is_string_view<std::tuple<T...>> : _has_string_view<T...> {};
+
+template <typename T, typename... Ts>
+struct _has_string_view<T, Ts...>
+    : std::integral_constant<bool, _is_string_view<T>::value ||
+                                   _has_string_view<Ts...>::value> {};
+
+// Reads the results of a call returning T, the first of which is at
+// stack index first
+template <typename T>
+struct _call_results {
+    static_assert(!_is_string_view<T>::value,
+                  "Results cannot be string views; use std::string");
+
+    static T get(lua_State *l, int first) {
+        return _get(_id<T>{}, l, first);
+    }
+};
+
+template <>
+struct _call_results<void> {
+    static void get(lua_State *, int) {}
+};
+
+template <typename... Ts>
+struct _call_results<std::tuple<Ts...>> {
+    static_assert(!_has_string_view<Ts...>::value,
+                  "Results cannot be string views; use std::string");
+
+    template <std::size_t... N>
+    static std::tuple<Ts...> worker(lua_State *l, int first,
+                                    _indices<N...>) {
+        return std::tuple<Ts...>(_get(_id<Ts>{}, l, first + N)...);
+    }
+
+    static std::tuple<Ts...> get(lua_State *l, int first) {
+        return worker(l, first,
+                      typename _indices_builder<sizeof...(Ts)>::type());
+    }
+};
+
 template <typename T>
 T _pop(_id<T> t, lua_State *l) {
     T ret =  _get(t, l, -1);
@@ -315,6 +517,7 @@ _push(lua_State *l, T&& t) {
     void *addr = lua_newuserdata(l, sizeof(T));
     new(addr) T(std::forward<T>(t));
     MetatableRegistry::SetMetatable(l, typeid(T));
+    _track_owned_userdata(l);
 }
 
 inline void _push(lua_State *l, bool b) {
@@ -347,6 +550,16 @@ inline void _push(lua_State *l, const char *s) {
     lua_pushstring(l, s);
 }
 
+inline void _push(lua_State *l, sel::string_view s) {
+    lua_pushlstring(l, s.data(), s.size());
+}
+
+#if __cplusplus >= 201703L
+inline void _push(lua_State *l, std::string_view s) {
+    lua_pushlstring(l, s.data(), s.size());
+}
+#endif
+
 template <typename T>
 inline void _set(lua_State *l, T &&value, const int index) {
     _push(l, std::forward<T>(value));
@@ -382,5 +595,335 @@ inline void _push(lua_State *l, std::tuple<T...> &&values) {
     _push(l, const_cast<const std::tuple<T...> &>(values));
 }
 
+/* Sequences */
+
+// Fills a table with the elements of [first, last), preallocating the
+// array part for all of them
+template <typename It>
+inline void _push_sequence(lua_State *l, It first, It last, std::size_t size) {
+    lua_createtable(l, static_cast<int>(size), 0);
+    const int table = lua_gettop(l);
+    int i = 0;
+    for (; first != last; ++first) {
+        _push(l, *first);
+        lua_rawseti(l, table, ++i);
+    }
+}
+
+template <typename T>
+inline void _push(lua_State *l, const std::vector<T> &values) {
+    _push_sequence(l, values.begin(), values.end(), values.size());
+}
+
+template <typename T, std::size_t N>
+inline void _push(lua_State *l, const std::array<T, N> &values) {
+    _push_sequence(l, values.begin(), values.end(), N);
+}
+
+template <typename T>
+inline void _push(lua_State *l, ArrayView<T> view) {
+    _push_array_view(l, view);
+}
+
+template <typename T>
+inline std::vector<T> _get(_id<std::vector<T>>, lua_State *l, const int index) {
+    std::vector<T> result;
+    if (!lua_istable(l, index)) return result;
+    const int table = lua_absindex(l, index);
+    const int size = static_cast<int>(lua_rawlen(l, table));
+    result.reserve(size);
+    for (int i = 1; i <= size; ++i) {
+        lua_rawgeti(l, table, i);
+        result.push_back(_get(_id<T>{}, l, -1));
+        lua_pop(l, 1);
+    }
+    return result;
+}
+
+template <typename T, std::size_t N>
+inline std::array<T, N> _get(_id<std::array<T, N>>, lua_State *l, const int index) {
+    std::array<T, N> result{};
+    if (!lua_istable(l, index)) return result;
+    const int table = lua_absindex(l, index);
+    for (std::size_t i = 0; i < N; ++i) {
+        lua_rawgeti(l, table, static_cast<int>(i + 1));
+        result[i] = _get(_id<T>{}, l, -1);
+        lua_pop(l, 1);
+    }
+    return result;
+}
+
+template <typename T>
+inline ArrayView<T> _get(_id<ArrayView<T>>, lua_State *l, const int index) {
+    ArrayView<T> *view = _to_array_view<T>(l, index);
+    return view == nullptr ? ArrayView<T>{} : *view;
+}
+
+inline void _check_table(lua_State *l, const int index) {
+    if (!lua_istable(l, index)) {
+        throw GetParameterFromLuaTypeError{
+            [](lua_State *l, int index){luaL_checktype(l, index, LUA_TTABLE);},
+            index
+        };
+    }
+}
+
+// Converts the value at index, which belongs to the table at table. A
+// conversion error is reported for the table, since the value is not a
+// parameter of the call.
+template <typename T>
+inline T _check_get_entry(lua_State *l, const int index, const int table) {
+    try {
+        return _check_get(_id<T>{}, l, index);
+    } catch (GetParameterFromLuaTypeError &) {
+    } catch (GetUserdataParameterFromLuaTypeError &) {
+    }
+    throw GetParameterFromLuaTypeError{
+        [](lua_State *l, int index){luaL_argerror(l, index, "table element of the wrong type");},
+        table
+    };
+}
+
+// Element i of the table at index table
+template <typename T>
+inline T _check_get_element(lua_State *l, const int table, const int i) {
+    lua_rawgeti(l, table, i);
+    T element = _check_get_entry<T>(l, -1, table);
+    lua_pop(l, 1);
+    return element;
+}
+
+template <typename T>
+inline std::vector<T> _check_get(_id<std::vector<T>>, lua_State *l, const int index) {
+    _check_table(l, index);
+    const int table = lua_absindex(l, index);
+    const int size = static_cast<int>(lua_rawlen(l, table));
+    std::vector<T> result;
+    result.reserve(size);
+    for (int i = 1; i <= size; ++i) {
+        result.push_back(_check_get_element<T>(l, table, i));
+    }
+    return result;
+}
+
+template <typename T, std::size_t N>
+inline std::array<T, N> _check_get(_id<std::array<T, N>>, lua_State *l, const int index) {
+    _check_table(l, index);
+    const int table = lua_absindex(l, index);
+    if (lua_rawlen(l, table) != N) {
+        throw GetParameterFromLuaTypeError{
+            [](lua_State *l, int index){luaL_argerror(l, index, "table of the wrong size");},
+            table
+        };
+    }
+    std::array<T, N> result{};
+    for (std::size_t i = 0; i < N; ++i) {
+        result[i] = _check_get_element<T>(l, table, static_cast<int>(i + 1));
+    }
+    return result;
+}
+
+template <typename T>
+inline ArrayView<T> _check_get(_id<ArrayView<T>>, lua_State *l, const int index) {
+    ArrayView<T> *view = _to_array_view<T>(l, index);
+    if (view == nullptr) {
+        throw GetParameterFromLuaTypeError{
+            [](lua_State *l, int index){luaL_argerror(l, index, "array view expected");},
+            index
+        };
+    }
+    return *view;
+}
+
+/* Tables with arbitrary keys */
+
+// Fills a table with the pairs of [first, last), preallocating the hash
+// part for all of them
+template <typename It>
+inline void _push_entries(lua_State *l, It first, It last, std::size_t size) {
+    lua_createtable(l, 0, static_cast<int>(size));
+    const int table = lua_gettop(l);
+    for (; first != last; ++first) {
+        _push(l, first->first);
+        _push(l, first->second);
+        lua_rawset(l, table);
+    }
+}
+
+template <typename K, typename V, typename C, typename A>
+inline void _push(lua_State *l, const std::map<K, V, C, A> &entries) {
+    _push_entries(l, entries.begin(), entries.end(), entries.size());
+}
+
+template <typename K, typename V, typename H, typename E, typename A>
+inline void _push(lua_State *l, const std::unordered_map<K, V, H, E, A> &entries) {
+    _push_entries(l, entries.begin(), entries.end(), entries.size());
+}
+
+template <typename K, typename V>
+inline void _push(lua_State *l, const std::vector<std::pair<K, V>> &entries) {
+    _push_entries(l, entries.begin(), entries.end(), entries.size());
+}
+
+// Calls insert(key, value) for every entry of the table at index. The
+// key is converted from a copy, since converting a number key to a
+// string in place would confuse lua_next.
+template <typename K, typename V, bool Checked, typename Insert>
+inline void _get_entries(lua_State *l, const int index, Insert insert) {
+    const int table = lua_absindex(l, index);
+    lua_pushnil(l);
+    while (lua_next(l, table) != 0) {
+        lua_pushvalue(l, -2);
+        if (Checked) {
+            insert(_check_get_entry<K>(l, -1, table), _check_get_entry<V>(l, -2, table));
+        } else {
+            insert(_get(_id<K>{}, l, -1), _get(_id<V>{}, l, -2));
+        }
+        lua_pop(l, 2);
+    }
+}
+
+template <typename Map>
+inline Map _get_map(lua_State *l, const int index) {
+    using K = typename Map::key_type;
+    using V = typename Map::mapped_type;
+    Map result;
+    if (!lua_istable(l, index)) return result;
+    _get_entries<K, V, false>(l, index, [&result](K key, V value) {
+        result.emplace(std::move(key), std::move(value));
+    });
+    return result;
+}
+
+template <typename Map>
+inline Map _check_get_map(lua_State *l, const int index) {
+    using K = typename Map::key_type;
+    using V = typename Map::mapped_type;
+    _check_table(l, index);
+    Map result;
+    _get_entries<K, V, true>(l, index, [&result](K key, V value) {
+        result.emplace(std::move(key), std::move(value));
+    });
+    return result;
+}
+
+template <typename K, typename V, typename C, typename A>
+inline std::map<K, V, C, A> _get(_id<std::map<K, V, C, A>>, lua_State *l, const int index) {
+    return _get_map<std::map<K, V, C, A>>(l, index);
+}
+
+template <typename K, typename V, typename H, typename E, typename A>
+inline std::unordered_map<K, V, H, E, A> _get(_id<std::unordered_map<K, V, H, E, A>>,
+                                              lua_State *l, const int index) {
+    return _get_map<std::unordered_map<K, V, H, E, A>>(l, index);
+}
+
+template <typename K, typename V>
+inline std::vector<std::pair<K, V>> _get(_id<std::vector<std::pair<K, V>>>,
+                                         lua_State *l, const int index) {
+    std::vector<std::pair<K, V>> result;
+    if (!lua_istable(l, index)) return result;
+    _get_entries<K, V, false>(l, index, [&result](K key, V value) {
+        result.emplace_back(std::move(key), std::move(value));
+    });
+    return result;
+}
+
+template <typename K, typename V, typename C, typename A>
+inline std::map<K, V, C, A> _check_get(_id<std::map<K, V, C, A>>,
+                                       lua_State *l, const int index) {
+    return _check_get_map<std::map<K, V, C, A>>(l, index);
+}
+
+template <typename K, typename V, typename H, typename E, typename A>
+inline std::unordered_map<K, V, H, E, A> _check_get(_id<std::unordered_map<K, V, H, E, A>>,
+                                                    lua_State *l, const int index) {
+    return _check_get_map<std::unordered_map<K, V, H, E, A>>(l, index);
+}
+
+template <typename K, typename V>
+inline std::vector<std::pair<K, V>> _check_get(_id<std::vector<std::pair<K, V>>>,
+                                               lua_State *l, const int index) {
+    _check_table(l, index);
+    std::vector<std::pair<K, V>> result;
+    _get_entries<K, V, true>(l, index, [&result](K key, V value) {
+        result.emplace_back(std::move(key), std::move(value));
+    });
+    return result;
+}
+
+/* Structs described with SEL_FIELDS */
+
+// The fields are stored as a flat tuple of names and member pointers
+template <typename T, typename M>
+inline void _push_field(lua_State *l, const int table, const T &value,
+                        const char *name, M T::*member) {
+    _push(l, value.*member);
+    lua_setfield(l, table, name);
+}
+
+template <typename T, typename Fields, std::size_t... N>
+inline void _push_fields(lua_State *l, const T &value, const Fields &fields,
+                         _indices<N...>) {
+    lua_createtable(l, 0, sizeof...(N));
+    const int table = lua_gettop(l);
+    using expand = int[];
+    (void)expand{0, (_push_field(l, table, value, std::get<2 * N>(fields),
+                                 std::get<2 * N + 1>(fields)), 0)...};
+}
+
+template <typename T>
+inline typename std::enable_if<_has_fields<T>::value>::type
+_push(lua_State *l, const T &value) {
+    constexpr std::size_t num_fields = std::tuple_size<_fields_type<T>>::value / 2;
+    _push_fields(l, value, selene_fields(_id<T>{}),
+                 typename _indices_builder<num_fields>::type());
+}
+
+// Reads a field of the table at index table into result. Missing fields
+// keep their default value.
+template <bool Checked, typename T, typename M>
+inline void _get_field(lua_State *l, const int table, T &result,
+                       const char *name, M T::*member) {
+    lua_pushstring(l, name);
+    lua_rawget(l, table);
+    if (!lua_isnil(l, -1)) {
+        result.*member = Checked ? _check_get_entry<M>(l, -1, table)
+                                 : _get(_id<M>{}, l, -1);
+    }
+    lua_pop(l, 1);
+}
+
+template <bool Checked, typename T, typename Fields, std::size_t... N>
+inline void _get_fields(lua_State *l, const int table, T &result,
+                        const Fields &fields, _indices<N...>) {
+    using expand = int[];
+    (void)expand{0, (_get_field<Checked>(l, table, result, std::get<2 * N>(fields),
+                                         std::get<2 * N + 1>(fields)), 0)...};
+}
+
+template <bool Checked, typename T>
+inline T _get_struct(lua_State *l, const int index) {
+    constexpr std::size_t num_fields = std::tuple_size<_fields_type<T>>::value / 2;
+    T result{};
+    _get_fields<Checked>(l, lua_absindex(l, index), result, selene_fields(_id<T>{}),
+                         typename _indices_builder<num_fields>::type());
+    return result;
+}
+
+template <typename T>
+inline typename std::enable_if<_has_fields<T>::value, T>::type
+_get(_id<T>, lua_State *l, const int index) {
+    if (!lua_istable(l, index)) return T{};
+    return _get_struct<false, T>(l, index);
+}
+
+template <typename T>
+inline typename std::enable_if<_has_fields<T>::value, T>::type
+_check_get(_id<T>, lua_State *l, const int index) {
+    _check_table(l, index);
+    return _get_struct<true, T>(l, index);
+}
+
 }
 }
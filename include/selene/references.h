@@ -15,6 +15,20 @@ public:
       : _lifetime(std::move(lifetime))
       , _obj(&obj) {}
 
+    Reference(const Reference &other)
+      : _lifetime(other._lifetime.Copy())
+      , _obj(other._obj) {}
+
+    Reference(Reference &&) = default;
+
+    Reference & operator=(const Reference &other) {
+        _lifetime = other._lifetime.Copy();
+        _obj = other._obj;
+        return *this;
+    }
+
+    Reference & operator=(Reference &&) = default;
+
     T& get() const {
         return *_obj;
     }
@@ -42,6 +56,20 @@ public:
       : Pointer(nullptr, std::move(lifetime))
     {}
 
+    Pointer(const Pointer &other)
+      : _lifetime(other._lifetime.Copy())
+      , _obj(other._obj) {}
+
+    Pointer(Pointer &&) = default;
+
+    Pointer & operator=(const Pointer &other) {
+        _lifetime = other._lifetime.Copy();
+        _obj = other._obj;
+        return *this;
+    }
+
+    Pointer & operator=(Pointer &&) = default;
+
     T* get() const {
         return _obj;
     }
@@ -104,7 +132,7 @@ inline sel::Reference<T> _check_get(_id<sel::Reference<T>>,
     T& result = _check_get(_id<T&>{}, l, index);
     lua_pushvalue(l, index);
     LuaRef lifetime(l, luaL_ref(l, LUA_REGISTRYINDEX));
-    return {result, lifetime};
+    return {result, std::move(lifetime)};
 }
 
 template <typename T>
@@ -113,7 +141,7 @@ inline sel::Reference<T> _get(_id<sel::Reference<T>>,
     T& result = _get(_id<T&>{}, l, index);
     lua_pushvalue(l, index);
     LuaRef lifetime(l, luaL_ref(l, LUA_REGISTRYINDEX));
-    return {result, lifetime};
+    return {result, std::move(lifetime)};
 }
 
 template<typename T>
@@ -134,7 +162,7 @@ inline sel::Pointer<T> _check_get(_id<sel::Pointer<T>>,
     if(result) {
         lua_pushvalue(l, index);
         LuaRef lifetime(l, luaL_ref(l, LUA_REGISTRYINDEX));
-        return {result, lifetime};
+        return {result, std::move(lifetime)};
     } else {
         return {LuaRef(l)};
     }
@@ -147,7 +175,7 @@ inline sel::Pointer<T> _get(_id<sel::Pointer<T>>,
     if(result) {
         lua_pushvalue(l, index);
         LuaRef lifetime(l, luaL_ref(l, LUA_REGISTRYINDEX));
-        return {result, lifetime};
+        return {result, std::move(lifetime)};
     } else {
         return {LuaRef(l)};
     }
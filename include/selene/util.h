@@ -1,5 +1,6 @@
 #pragma once
 
+#include "Allocator.h"
 #include "ExceptionHandler.h"
 #include <iostream>
 #include <utility>
@@ -90,6 +91,17 @@ inline int SetErrorHandler(lua_State *L) {
     return lua_gettop(L);
 }
 
+// Returns the stack index of the message handler to pass to
+// lua_pcall. The handler at pinned_index is reused when it is still in
+// place; otherwise a new one is pushed.
+inline int UseErrorHandler(lua_State *L, int pinned_index) {
+    if (pinned_index != 0 && pinned_index <= lua_gettop(L) &&
+        lua_tocfunction(L, pinned_index) == &ErrorHandler) {
+        return pinned_index;
+    }
+    return SetErrorHandler(L);
+}
+
 template<typename T, typename... Args>
 std::unique_ptr<T> make_unique(Args&&... args) {
     return std::unique_ptr<T>(new T(std::forward<Args>(args)...));
@@ -1,12 +1,17 @@
 #include <algorithm>
+#include "allocator_tests.h"
 #include "class_tests.h"
+#include "container_tests.h"
 #include "obj_tests.h"
+#include "pool_tests.h"
 #include "interop_tests.h"
+#include "load_tests.h"
 #include "metatable_tests.h"
 #include "reference_tests.h"
 #include "selector_tests.h"
 #include "error_tests.h"
 #include "exception_tests.h"
+#include "gc_tests.h"
 #include <map>
 
 // A very simple testing framework
@@ -45,10 +50,14 @@ static TestMap tests = {
     {"test_call_lambda", test_call_lambda},
     {"test_call_normal_c_fun", test_call_normal_c_fun},
     {"test_call_normal_c_fun_many_times", test_call_normal_c_fun_many_times},
+    {"test_call_static_fun", test_call_static_fun},
+    {"test_call_stateless_lambda_many_times", test_call_stateless_lambda_many_times},
     {"test_call_functor", test_call_functor},
     {"test_multivalue_c_fun_return", test_multivalue_c_fun_return},
     {"test_multivalue_c_fun_from_lua", test_multivalue_c_fun_from_lua},
     {"test_embedded_nulls", test_embedded_nulls},
+    {"test_string_view_parameter", test_string_view_parameter},
+    {"test_string_view_return", test_string_view_return},
     {"test_coroutine", test_coroutine},
     {"test_pointer_return", test_pointer_return},
     {"test_reference_return", test_reference_return},
@@ -66,6 +75,22 @@ static TestMap tests = {
     {"test_call_with_primitive_by_const_ref", test_call_with_primitive_by_const_ref},
     {"test_call_with_primitive_by_rvalue_ref", test_call_with_primitive_by_rvalue_ref},
 
+    {"test_push_vector", test_push_vector},
+    {"test_get_vector", test_get_vector},
+    {"test_vector_parameter_and_return", test_vector_parameter_and_return},
+    {"test_vector_parameter_wrong_element", test_vector_parameter_wrong_element},
+    {"test_array", test_array},
+    {"test_array_view", test_array_view},
+    {"test_array_view_errors", test_array_view_errors},
+    {"test_push_map", test_push_map},
+    {"test_get_map", test_get_map},
+    {"test_map_parameter_and_return", test_map_parameter_and_return},
+    {"test_map_parameter_wrong_value", test_map_parameter_wrong_value},
+    {"test_push_struct", test_push_struct},
+    {"test_get_struct", test_get_struct},
+    {"test_struct_parameter_and_return", test_struct_parameter_and_return},
+    {"test_struct_parameter_wrong_field", test_struct_parameter_wrong_field},
+
     {"test_metatable_registry_ptr", test_metatable_registry_ptr},
     {"test_metatable_registry_ref", test_metatable_registry_ref},
     {"test_metatable_ptr_member", test_metatable_ptr_member},
@@ -90,6 +115,7 @@ static TestMap tests = {
     {"test_select_index", test_select_index},
     {"test_select_nested_field", test_select_nested_field},
     {"test_select_nested_index", test_select_nested_index},
+    {"test_select_name_kinds", test_select_name_kinds},
     {"test_select_equality", test_select_equality},
     {"test_select_cast", test_select_cast},
     {"test_set_global", test_set_global},
@@ -99,6 +125,8 @@ static TestMap tests = {
     {"test_set_nested_index", test_set_nested_index},
     {"test_create_table_field", test_create_table_field},
     {"test_create_table_index", test_create_table_index},
+    {"test_read_does_not_create_table", test_read_does_not_create_table},
+    {"test_create_deep_table_field", test_create_deep_table_field},
     {"test_cache_selector_field_assignment", test_cache_selector_field_assignment},
     {"test_cache_selector_field_access", test_cache_selector_field_access},
     {"test_cache_selector_function", test_cache_selector_function},
@@ -118,14 +146,67 @@ static TestMap tests = {
     {"test_selector_get_wrong_ref_to_table", test_selector_get_wrong_ref_to_table},
     {"test_selector_get_wrong_ref_to_unregistered", test_selector_get_wrong_ref_to_unregistered},
     {"test_selector_get_wrong_ptr", test_selector_get_wrong_ptr},
+    {"test_selector_call", test_selector_call},
+    {"test_selector_call_no_return", test_selector_call_no_return},
+    {"test_selector_call_multi_return", test_selector_call_multi_return},
+    {"test_selector_call_field", test_selector_call_field},
+    {"test_selector_call_error", test_selector_call_error},
+    {"test_batched_calls", test_batched_calls},
+    {"test_batched_calls_error", test_batched_calls_error},
+    {"test_batched_calls_replace_handler", test_batched_calls_replace_handler},
+    {"test_table_size", test_table_size},
+    {"test_table_for_each", test_table_for_each},
+    {"test_table_pairs", test_table_pairs},
+    {"test_table_pairs_number_key_views", test_table_pairs_number_key_views},
+    {"test_bound_selector_get", test_bound_selector_get},
+    {"test_bound_selector_set", test_bound_selector_set},
+    {"test_bound_selector_invalidate", test_bound_selector_invalidate},
+
+    {"test_pool_allocator_state", test_pool_allocator_state},
+    {"test_allocator_stats", test_allocator_stats},
+    {"test_memory_hard_limit", test_memory_hard_limit},
+    {"test_memory_hard_limit_in_callback", test_memory_hard_limit_in_callback},
+    {"test_memory_soft_limit", test_memory_soft_limit},
+    {"test_gc_step_with_budget", test_gc_step_with_budget},
+    {"test_gc_collect_stats", test_gc_collect_stats},
+    {"test_gc_mode", test_gc_mode},
+    {"test_state_pool_reuses_states", test_state_pool_reuses_states},
+    {"test_state_pool_resets_globals", test_state_pool_resets_globals},
+    {"test_state_pool_replaces_stale_states", test_state_pool_replaces_stale_states},
+    {"test_state_pool_resets_settings", test_state_pool_resets_settings},
+    {"test_state_pool_factory", test_state_pool_factory},
+    {"test_snapshot_restore", test_snapshot_restore},
+    {"test_snapshot_shallow_keeps_nested_changes", test_snapshot_shallow_keeps_nested_changes},
+    {"test_snapshot_deep", test_snapshot_deep},
+    {"test_snapshot_stale", test_snapshot_stale},
+    {"test_compile_and_load_bytecode", test_compile_and_load_bytecode},
+    {"test_load_bytecode_rejects_source", test_load_bytecode_rejects_source},
+    {"test_bytecode_cache", test_bytecode_cache},
+    {"test_chunk_cache", test_chunk_cache},
+    {"test_chunk_cache_errors", test_chunk_cache_errors},
+    {"test_load_mapped_script", test_load_mapped_script},
+    {"test_load_missing_script", test_load_missing_script},
+    {"test_load_bundle", test_load_bundle},
+    {"test_load_bundle_missing_module", test_load_bundle_missing_module},
+    {"test_load_invalid_bundle", test_load_invalid_bundle},
 
     {"test_register_class", test_register_class},
     {"test_get_member_variable", test_get_member_variable},
     {"test_set_member_variable", test_set_member_variable},
     {"test_class_field_set", test_class_field_set},
+    {"test_class_static_member_fun", test_class_static_member_fun},
+    {"test_class_property_get_set", test_class_property_get_set},
+    {"test_class_property_select", test_class_property_select},
+    {"test_class_property_read_only", test_class_property_read_only},
     {"test_class_gc", test_class_gc},
+    {"test_teardown_finalize_owned", test_teardown_finalize_owned},
+    {"test_teardown_finalize_owned_created_before", test_teardown_finalize_owned_created_before},
+    {"test_teardown_abandon", test_teardown_abandon},
+    {"test_teardown_close", test_teardown_close},
     {"test_ctor_wrong_type", test_ctor_wrong_type},
     {"test_pass_wrong_type", test_pass_wrong_type},
+    {"test_pass_foreign_metatable", test_pass_foreign_metatable},
+    {"test_method_wrong_self", test_method_wrong_self},
     {"test_pass_pointer", test_pass_pointer},
     {"test_pass_ref", test_pass_ref},
     {"test_return_pointer", test_return_pointer},
@@ -141,6 +222,8 @@ static TestMap tests = {
     {"test_pass_function_to_lua", test_pass_function_to_lua},
     {"test_call_returned_lua_function", test_call_returned_lua_function},
     {"test_call_multivalue_lua_function", test_call_multivalue_lua_function},
+    {"test_copied_function_outlives_original", test_copied_function_outlives_original},
+    {"test_copied_reference_outlives_original", test_copied_reference_outlives_original},
     {"test_call_result_is_alive_ptr", test_call_result_is_alive_ptr},
     {"test_call_result_is_alive_ref", test_call_result_is_alive_ref},
     {"test_function_call_with_registered_class", test_function_call_with_registered_class},
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <selene.h>
+
+bool test_pool_allocator_state(sel::State &) {
+    sel::State state{sel::make_unique<sel::PoolAllocator>(), true};
+    state("t = {} for i = 1, 1000 do t[i] = tostring(i) end");
+    state("s = table.concat(t)");
+    const bool check1 = state["t"][500] == "500";
+    const std::string s = state["s"];
+    const bool check2 = s.size() == 2893;
+    const bool check3 = state.Size() == 0;
+    return check1 && check2 && check3;
+}
+
+bool test_allocator_stats(sel::State &) {
+    sel::State state{sel::make_unique<sel::DefaultAllocator>()};
+    const sel::AllocatorStats before = state.MemoryStats();
+    state("t = {} for i = 1, 1000 do t[i] = {} end");
+    const sel::AllocatorStats after = state.MemoryStats();
+    state("t = nil");
+    state.ForceGC();
+    const sel::AllocatorStats collected = state.MemoryStats();
+    return after.allocations >= before.allocations + 1000 &&
+        after.bytes_in_use > before.bytes_in_use &&
+        collected.bytes_in_use < after.bytes_in_use &&
+        collected.frees >= after.frees + 1000 &&
+        collected.peak_bytes >= after.bytes_in_use;
+}
+
+bool test_memory_hard_limit(sel::State &) {
+    sel::State state{sel::make_unique<sel::DefaultAllocator>(), true};
+    const std::size_t base = state.MemoryStats().bytes_in_use;
+    state.GetAllocator()->SetMemoryLimits(0, base + 1024 * 1024);
+
+    int error_status = 0;
+    state.HandleExceptionsWith([&error_status](int status, std::string, std::exception_ptr) {
+        error_status = status;
+    });
+    state("t = {} for i = 1, 1e7 do t[i] = {} end");
+    const bool check1 = error_status == LUA_ERRMEM;
+    const bool check2 = state.MemoryStats().refused > 0;
+
+    // The state stays usable once the memory is released
+    state("t = nil");
+    state.ForceGC();
+    error_status = 0;
+    state("x = 5");
+    return check1 && check2 && error_status == 0 && state["x"] == 5;
+}
+
+bool test_memory_hard_limit_in_callback(sel::State &) {
+    sel::State state{sel::make_unique<sel::DefaultAllocator>(), true};
+    state["make"] = [](int n) { return std::string(n, 'x'); };
+    state("s = '' n = 0");
+    const std::size_t base = state.MemoryStats().bytes_in_use;
+    state.GetAllocator()->SetMemoryLimits(0, base + 64 * 1024);
+
+    int error_status = 0;
+    state.HandleExceptionsWith([&error_status](int status, std::string, std::exception_ptr) {
+        error_status = status;
+    });
+    // The string is pushed by C++ code, where the hard limit is lifted
+    state("n = #make(256 * 1024)");
+    const bool check1 = error_status == 0 && state["n"] == 256 * 1024;
+
+    // Lua code called back from C++ is limited again
+    state["call"] = [&state]() { state("t = {} for i = 1, 1e7 do t[i] = {} end"); };
+    state("call()");
+    const bool check2 = error_status == LUA_ERRMEM;
+
+    state("t = nil");
+    state.ForceGC();
+    error_status = 0;
+    state("x = 5");
+    return check1 && check2 && error_status == 0 && state["x"] == 5;
+}
+
+bool test_memory_soft_limit(sel::State &) {
+    sel::State state{sel::make_unique<sel::DefaultAllocator>(), true};
+    state("garbage = {} for i = 1, 10000 do garbage[i] = {} end garbage = nil");
+    const std::size_t with_garbage = state.MemoryStats().bytes_in_use;
+    state.GetAllocator()->SetMemoryLimits(with_garbage / 2, 0);
+    state("x = 1");
+    return state.MemoryStats().bytes_in_use < with_garbage;
+}
@@ -99,6 +99,59 @@ bool test_set_member_variable(sel::State &state) {
     return state["barx"] == -4;
 }
 
+bool test_class_static_member_fun(sel::State &state) {
+    state["Bar"].SetClass<Bar, int>("set", SEL_FUN(&Bar::SetX),
+                                    "get", SEL_FUN(&Bar::GetX),
+                                    "print", SEL_FUN(&Bar::Print));
+    state("bar = Bar.new(4)");
+    state("bar:set(6)");
+    state("x = bar:get()");
+    state("s = bar:print(2)");
+    return state["x"] == 6 && state["s"] == "6+2";
+}
+
+struct Stats {
+    int hp;
+    const int max_hp;
+    Stats(int num) : hp(num), max_hp(num * 2) {}
+
+    int GetHp() {
+        return hp;
+    }
+};
+
+bool test_class_property_get_set(sel::State &state) {
+    state["Stats"].SetClass<Stats, int>("hp", sel::property(&Stats::hp),
+                                        "max_hp", sel::property(&Stats::max_hp),
+                                        "get_hp", &Stats::GetHp);
+    state("stats = Stats.new(4)");
+    state("stats.hp = stats.hp + stats.max_hp");
+    state("hp = stats:get_hp()");
+    return state["hp"] == 12;
+}
+
+bool test_class_property_select(sel::State &state) {
+    state["Stats"].SetClass<Stats, int>("hp", sel::property(&Stats::hp));
+    state("stats = Stats.new(4)");
+    state["stats"]["hp"] = 7;
+    int hp = state["stats"]["hp"];
+    return hp == 7 && state["stats"]["hp"] == 7 && !state["stats"]["mp"].exists();
+}
+
+bool test_class_property_read_only(sel::State &state) {
+    state["Stats"].SetClass<Stats, int>("max_hp", sel::property(&Stats::max_hp));
+    state("stats = Stats.new(4)");
+
+    bool error_encounted = false;
+    state.HandleExceptionsWith([&error_encounted](int, std::string, std::exception_ptr) {
+        error_encounted = true;
+    });
+
+    state("stats.max_hp = 1");
+    state("max_hp = stats.max_hp");
+    return error_encounted && state["max_hp"] == 8;
+}
+
 bool test_class_field_set(sel::State &state) {
     state["Bar"].SetClass<Bar, int>("set", &Bar::SetX, "get", &Bar::GetX);
     state("bar = Bar.new(4)");
@@ -122,6 +175,55 @@ bool test_class_gc(sel::State &state) {
     return check1 && check2;
 }
 
+bool test_teardown_finalize_owned(sel::State &) {
+    gc_counter = 0;
+    {
+        sel::State state{sel::make_unique<sel::PoolAllocator>(), true};
+        state.SetTeardown(sel::Teardown::FinalizeOwned);
+        state["GCTest"].SetClass<GCTest>();
+        state("a = GCTest.new() b = GCTest.new() GCTest.new()");
+        state.ForceGC();
+        if (gc_counter != 2) return false;
+        state("big = string.rep('x', 100000)");
+    }
+    return gc_counter == 0;
+}
+
+bool test_teardown_finalize_owned_created_before(sel::State &) {
+    gc_counter = 0;
+    {
+        sel::State state{sel::make_unique<sel::PoolAllocator>(), true};
+        state["GCTest"].SetClass<GCTest>();
+        state("a = GCTest.new()");
+        state.SetTeardown(sel::Teardown::FinalizeOwned);
+        state("b = GCTest.new()");
+        if (gc_counter != 2) return false;
+    }
+    return gc_counter == 0;
+}
+
+bool test_teardown_abandon(sel::State &) {
+    gc_counter = 0;
+    {
+        sel::State state{sel::make_unique<sel::PoolAllocator>(), true};
+        state.SetTeardown(sel::Teardown::Abandon);
+        state["GCTest"].SetClass<GCTest>();
+        state("a = GCTest.new()");
+    }
+    return gc_counter == 1;
+}
+
+bool test_teardown_close(sel::State &) {
+    gc_counter = 0;
+    {
+        sel::State state{true};
+        state.SetTeardown(sel::Teardown::Close);
+        state["GCTest"].SetClass<GCTest>();
+        state("a = GCTest.new()");
+    }
+    return gc_counter == 0;
+}
+
 bool test_ctor_wrong_type(sel::State &state) {
     state["Bar"].SetClass<Bar, int>();
     state["Zoo"].SetClass<Zoo, Bar*>();
@@ -153,6 +255,38 @@ bool test_pass_wrong_type(sel::State &state) {
     state("zooAcceptor:acceptZoo(bar)");
     return error_encounted;
 }
+
+bool test_pass_foreign_metatable(sel::State &state) {
+    state["Bar"].SetClass<Bar, int>();
+    state["Zoo"].SetClass<Zoo, Bar*>();
+
+    bool error_encounted = false;
+    state.HandleExceptionsWith([&error_encounted](int, std::string, std::exception_ptr) {
+        error_encounted = true;
+    });
+
+    state("zoo = Zoo.new(setmetatable({}, {}))");
+    return error_encounted;
+}
+
+bool test_method_wrong_self(sel::State &state) {
+    state["Bar"].SetClass<Bar, int>("get", &Bar::GetX);
+    state["Zoo"].SetClass<Zoo, Bar*>("get", &Zoo::GetX);
+    state("bar = Bar.new(4)");
+    state("zoo = Zoo.new(bar)");
+
+    bool error_encounted = false;
+    state.HandleExceptionsWith([&error_encounted](int, std::string, std::exception_ptr) {
+        error_encounted = true;
+    });
+
+    state("x = bar.get(zoo)");
+    const bool check1 = error_encounted;
+    error_encounted = false;
+    state("x = zoo.get(zoo)");
+    return check1 && !error_encounted && state["x"] == 4;
+}
+
 bool test_pass_pointer(sel::State &state) {
     state["Bar"].SetClass<Bar, int>();
     state["Zoo"].SetClass<Zoo, Bar*>("get", &Zoo::GetX);
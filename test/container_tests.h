@@ -0,0 +1,182 @@
+#pragma once
+
+#include <array>
+#include <map>
+#include <selene.h>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+bool test_push_vector(sel::State &state) {
+    state["v"] = std::vector<int>{1, 2, 3};
+    state("n = #v; s = v[1] + v[2] + v[3]");
+    const int n = state["n"];
+    const int s = state["s"];
+    return n == 3 && s == 6;
+}
+
+bool test_get_vector(sel::State &state) {
+    state("t = {1.5, 2.5}; nested = {{1}, {2, 3}}; words = {'a', 'b'}");
+    const std::vector<double> t = state["t"];
+    const std::vector<std::vector<int>> nested = state["nested"];
+    const std::vector<std::string> words = state["words"];
+    return t == std::vector<double>{1.5, 2.5} &&
+        nested.size() == 2 && nested[1] == std::vector<int>{2, 3} &&
+        words == std::vector<std::string>{"a", "b"};
+}
+
+bool test_vector_parameter_and_return(sel::State &state) {
+    state["sum"] = [](const std::vector<int> &values) {
+        int sum = 0;
+        for (int v : values) sum += v;
+        return sum;
+    };
+    state["range"] = [](int n) {
+        std::vector<int> values;
+        for (int i = 1; i <= n; ++i) values.push_back(i);
+        return values;
+    };
+    state("x = sum({1, 2, 3}); y = #range(4); z = sum(range(4))");
+    const int x = state["x"];
+    const int y = state["y"];
+    const int z = state["z"];
+    return x == 6 && y == 4 && z == 10;
+}
+
+bool test_vector_parameter_wrong_element(sel::State &state) {
+    std::string message;
+    state.HandleExceptionsWith([&message](int, std::string msg, std::exception_ptr) {
+        message = msg;
+    });
+    state["count"] = [](std::vector<int> values) { return static_cast<int>(values.size()); };
+    const bool ok = state("count({1, 'x'})");
+    return !ok && message.find("table element of the wrong type") != std::string::npos;
+}
+
+bool test_array(sel::State &state) {
+    state["a"] = std::array<int, 3>{{4, 5, 6}};
+    state("b = {a[3], a[2], a[1]}");
+    const std::array<int, 3> b = state["b"];
+    return b[0] == 6 && b[1] == 5 && b[2] == 4;
+}
+
+bool test_array_view(sel::State &state) {
+    std::vector<double> data{1, 2, 3};
+    state["data"] = sel::ArrayView<double>(data);
+    state("data[1] = data[1] * 10; n = #data; missing = data[4] == nil");
+    const int n = state["n"];
+    const bool missing = state["missing"];
+    return data[0] == 10 && data[2] == 3 && n == 3 && missing;
+}
+
+bool test_array_view_errors(sel::State &state) {
+    int errors = 0;
+    state.HandleExceptionsWith([&errors](int, std::string, std::exception_ptr) {
+        ++errors;
+    });
+    const int values[] = {7, 8};
+    std::vector<int> mutable_values{1, 2};
+    state["values"] = sel::ArrayView<const int>(values);
+    state["mutable_values"] = sel::ArrayView<int>(mutable_values);
+    const bool written = state("values[1] = 0");
+    const bool out_of_range = state("mutable_values[3] = 1");
+    return !written && !out_of_range && values[0] == 7 && errors == 2;
+}
+
+bool test_push_map(sel::State &state) {
+    state["m"] = std::map<std::string, int>{{"a", 1}, {"b", 2}};
+    state["u"] = std::unordered_map<int, std::string>{{10, "ten"}};
+    state("s = m.a + m.b; t = u[10]");
+    const int s = state["s"];
+    const std::string t = state["t"];
+    return s == 3 && t == "ten";
+}
+
+bool test_get_map(sel::State &state) {
+    state("t = {x = 1.5, y = 2.5, [3] = 4}");
+    const std::map<std::string, double> m = state["t"];
+    const std::unordered_map<std::string, double> u = state["t"];
+    return m.size() == 3 && m.at("x") == 1.5 && m.at("3") == 4 &&
+        u.size() == 3 && u.at("y") == 2.5;
+}
+
+bool test_map_parameter_and_return(sel::State &state) {
+    state["total"] = [](const std::unordered_map<std::string, int> &counts) {
+        int sum = 0;
+        for (const auto &entry : counts) sum += entry.second;
+        return sum;
+    };
+    state["pairs"] = []() {
+        return std::vector<std::pair<std::string, int>>{{"one", 1}, {"two", 2}};
+    };
+    state("x = total({a = 1, b = 2, c = 3}); y = pairs().two");
+    const int x = state["x"];
+    const int y = state["y"];
+    return x == 6 && y == 2;
+}
+
+bool test_map_parameter_wrong_value(sel::State &state) {
+    std::string message;
+    state.HandleExceptionsWith([&message](int, std::string msg, std::exception_ptr) {
+        message = msg;
+    });
+    state["total"] = [](std::map<std::string, int> counts) {
+        return static_cast<int>(counts.size());
+    };
+    const bool ok = state("total({a = 1, b = {}})");
+    return !ok && message.find("table element of the wrong type") != std::string::npos;
+}
+
+namespace fields_test {
+struct Point {
+    int x;
+    int y;
+};
+SEL_FIELDS(Point, "x", &Point::x, "y", &Point::y)
+
+struct Event {
+    int id;
+    std::string name;
+    std::vector<double> values;
+    Point pos;
+};
+SEL_FIELDS(Event, "id", &Event::id, "name", &Event::name,
+           "values", &Event::values, "pos", &Event::pos)
+}
+
+bool test_push_struct(sel::State &state) {
+    state["e"] = fields_test::Event{7, "click", {1.5, 2.5}, {1, 3}};
+    state("ok = e.id == 7 and e.name == 'click' and #e.values == 2 and e.pos.y == 3");
+    return state["ok"];
+}
+
+bool test_get_struct(sel::State &state) {
+    state("e = {id = 1, name = 'key', values = {4, 5}, pos = {x = 2}}");
+    const fields_test::Event e = state["e"];
+    return e.id == 1 && e.name == "key" && e.values.size() == 2 &&
+        e.pos.x == 2 && e.pos.y == 0;
+}
+
+bool test_struct_parameter_and_return(sel::State &state) {
+    state["shift"] = [](fields_test::Point p) {
+        p.x += 1;
+        return p;
+    };
+    state["points"] = std::vector<fields_test::Point>{{1, 2}, {3, 4}};
+    state("p = shift({x = 1, y = 2}); n = #points; last = points[2].y");
+    const fields_test::Point p = state["p"];
+    const int n = state["n"];
+    const int last = state["last"];
+    return p.x == 2 && p.y == 2 && n == 2 && last == 4;
+}
+
+bool test_struct_parameter_wrong_field(sel::State &state) {
+    std::string message;
+    state.HandleExceptionsWith([&message](int, std::string msg, std::exception_ptr) {
+        message = msg;
+    });
+    state["take"] = [](fields_test::Point p) { return p.x; };
+    const bool ok = state("take({x = {}})");
+    return !ok && message.find("table element of the wrong type") != std::string::npos;
+}
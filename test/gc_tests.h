@@ -0,0 +1,31 @@
+#pragma once
+
+#include <chrono>
+#include <selene.h>
+
+bool test_gc_step_with_budget(sel::State &state) {
+    state("garbage = {} for i = 1, 10000 do garbage[i] = {} end garbage = nil");
+    bool finished = false;
+    for (int i = 0; i < 10000 && !finished; ++i) {
+        finished = state.GC().Step(std::chrono::microseconds(100));
+    }
+    const sel::GCStats &stats = state.GC().Stats();
+    return finished && stats.steps > 0 && stats.bytes_collected > 0 &&
+        stats.full_collections == 0;
+}
+
+bool test_gc_collect_stats(sel::State &state) {
+    state.GC().SetPause(150);
+    state.GC().SetStepMultiplier(300);
+    state("garbage = {} for i = 1, 1000 do garbage[i] = {} end garbage = nil");
+    state.ForceGC();
+    const sel::GCStats &stats = state.GC().Stats();
+    return stats.full_collections == 1 && stats.bytes_collected > 0 &&
+        stats.max_pause <= stats.total_pause;
+}
+
+bool test_gc_mode(sel::State &state) {
+    state.GC().SetMode(sel::GCMode::Generational);
+    state("t = {} for i = 1, 1000 do t[i] = {} end t = nil");
+    return state.GC().SetMode(sel::GCMode::Incremental);
+}
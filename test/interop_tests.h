@@ -1,6 +1,7 @@
 #pragma once
 
 #include "common/lifetime.h"
+#include <cstring>
 #include <memory>
 #include <selene.h>
 #include <string>
@@ -111,6 +112,22 @@ bool test_call_normal_c_fun_many_times(sel::State &state) {
     return result;
 }
 
+bool test_call_static_fun(sel::State &state) {
+    state["cadd"] = SEL_FUN(&my_add);
+    const int answer = state["cadd"](4, 20);
+    return answer == 24;
+}
+
+bool test_call_stateless_lambda_many_times(sel::State &state) {
+    state["cmultiply"] = [](int x, int y){ return x * y; };
+    bool result = true;
+    for (int i = 0; i < 25; ++i) {
+        const int answer = state["cmultiply"](i, 2);
+        result = result && (answer == i * 2);
+    }
+    return result;
+}
+
 bool test_call_functor(sel::State &state) {
     struct the_answer {
         int answer = 42;
@@ -151,6 +168,31 @@ bool test_embedded_nulls(sel::State &state) {
     return result.size() == 4;
 }
 
+bool test_string_view_parameter(sel::State &state) {
+    const char *borrowed = nullptr;
+    std::size_t length = 0;
+    state["measure"] = [&borrowed, &length](sel::string_view s) {
+        borrowed = s.data();
+        length = s.size();
+        return s == sel::string_view{"a\0b", 3} ? 1 : 0;
+    };
+    state("s = 'a' .. string.char(0) .. 'b'; same = measure(s)");
+    const int same = state["same"];
+    return same == 1 && length == 3 && borrowed != nullptr;
+}
+
+bool test_string_view_return(sel::State &state) {
+    static const char text[] = "hello world";
+    state["greeting"] = []() { return sel::string_view{text, 5}; };
+    state["first_word"] = [](const char *s) {
+        return std::string{s, std::strcspn(s, " ")};
+    };
+    state("a = greeting(); b = first_word('hello there')");
+    const std::string a = state["a"];
+    const std::string b = state["b"];
+    return a == "hello" && b == "hello";
+}
+
 bool test_coroutine(sel::State &state) {
     state.Load("../test/test.lua");
     bool check1 = state["resume_co"]() == 1;
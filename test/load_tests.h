@@ -0,0 +1,134 @@
+#pragma once
+
+#include <cstdio>
+#include <fstream>
+#include <selene.h>
+#include <string>
+
+bool test_compile_and_load_bytecode(sel::State &state) {
+    const std::string bytecode = state.Compile("../test/test.lua");
+    if (bytecode.empty() || state["add"].exists()) return false;
+    const bool loaded = state.LoadBytecode(bytecode);
+    const int answer = state["add"](5, 2);
+    return loaded && answer == 7;
+}
+
+bool test_load_bytecode_rejects_source(sel::State &state) {
+    bool error_encounted = false;
+    state.HandleExceptionsWith([&error_encounted](int, std::string, std::exception_ptr) {
+        error_encounted = true;
+    });
+    return !state.LoadBytecode("x = 1") && error_encounted && !state["x"].exists();
+}
+
+bool test_bytecode_cache(sel::State &state) {
+    const std::string file = "../test/test.lua";
+    std::string source;
+    sel::detail::_read_file(file, source);
+    const std::string entry = sel::BytecodeCache{"."}.EntryPath(file, source);
+    std::remove(entry.c_str());
+
+    state.EnableBytecodeCache(".");
+    const bool first = state.Load(file);
+    std::string cached;
+    const bool written = sel::detail::_read_file(entry, cached) && !cached.empty();
+
+    sel::State other{true};
+    other.EnableBytecodeCache(".");
+    const bool second = other.Load(file);
+    const int answer = other["add"](5, 2);
+    // Debug information is kept
+    other("source = debug.getinfo(add, 'S').source");
+    std::remove(entry.c_str());
+    if (!other["source"].exists()) return false;
+    const std::string source_name = other["source"];
+    return first && written && second && answer == 7 && source_name == "@" + file;
+}
+
+bool test_chunk_cache(sel::State &state) {
+    state.EnableChunkCache(2);
+    state("x = 0");
+    for (int i = 0; i < 3; ++i) state("x = x + 1");
+    state.Run("double", "x = x * 2");
+    state.Run("double", "x = x * 2");
+    const int x = state["x"];
+    const sel::ChunkCacheStats &stats = state.ChunkStats();
+    return x == 12 && stats.hits == 3 && stats.misses == 3 &&
+        stats.evictions == 1;
+}
+
+bool test_chunk_cache_errors(sel::State &state) {
+    int errors = 0;
+    state.HandleExceptionsWith([&errors](int, std::string, std::exception_ptr) {
+        ++errors;
+    });
+    state.EnableChunkCache(4);
+    const bool syntax = state("x = = 1");
+    const bool runtime = state("error('fail')") || state("error('fail')");
+    return !syntax && !runtime && errors == 3 &&
+        state.ChunkStats().hits == 1 && state.ChunkStats().misses == 2;
+}
+
+bool test_load_mapped_script(sel::State &state) {
+    const std::string file = "selene_mapped_test.lua";
+    {
+        std::ofstream out(file, std::ios::binary);
+        out << "\xEF\xBB\xBF#!/usr/bin/env lua\nx = 1\nerror('boom')\n";
+    }
+    std::string message;
+    state.HandleExceptionsWith([&message](int, std::string msg, std::exception_ptr) {
+        message = msg;
+    });
+    const bool loaded = state.Load(file);
+    std::remove(file.c_str());
+    const int x = state["x"];
+    return !loaded && x == 1 &&
+        message.find("selene_mapped_test.lua:3:") != std::string::npos;
+}
+
+bool test_load_missing_script(sel::State &state) {
+    int errors = 0;
+    state.HandleExceptionsWith([&errors](int, std::string, std::exception_ptr) {
+        ++errors;
+    });
+    const sel::MappedFile mapped("does_not_exist.lua");
+    return !state.Load("does_not_exist.lua") && errors == 1 && !mapped.Valid();
+}
+
+bool test_load_bundle(sel::State &state) {
+    const std::string file = "selene_test.bundle";
+    sel::BundleWriter writer;
+    writer.Add("config.values", "return {answer = 42}");
+    writer.Add("script", state.Compile("../test/test.lua"));
+    if (!writer.Write(file)) return false;
+    const bool loaded = state.LoadBundle(file);
+    state("answer = require('config.values').answer; require('script')");
+    std::remove(file.c_str());
+    const int answer = state["answer"];
+    const int sum = state["add"](5, 2);
+    return loaded && answer == 42 && sum == 7;
+}
+
+bool test_load_bundle_missing_module(sel::State &state) {
+    std::string message;
+    state.HandleExceptionsWith([&message](int, std::string msg, std::exception_ptr) {
+        message = msg;
+    });
+    const std::string file = "selene_test.bundle";
+    sel::BundleWriter writer;
+    writer.Add("present", "return true");
+    writer.Write(file);
+    const bool loaded = state.LoadBundle(file);
+    const bool found = state("require('absent')");
+    std::remove(file.c_str());
+    return loaded && !found &&
+        message.find("no module 'absent' in bundle") != std::string::npos;
+}
+
+bool test_load_invalid_bundle(sel::State &state) {
+    int errors = 0;
+    state.HandleExceptionsWith([&errors](int, std::string, std::exception_ptr) {
+        ++errors;
+    });
+    return !state.LoadBundle("../test/test.lua") && errors == 1;
+}
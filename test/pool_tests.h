@@ -0,0 +1,128 @@
+#pragma once
+
+#include <selene.h>
+
+bool test_state_pool_reuses_states(sel::State &) {
+    int initialized = 0;
+    sel::StatePool pool([&initialized](sel::State &state) {
+        ++initialized;
+        state("counter = 0 function bump() counter = counter + 1 return counter end");
+    }, 1);
+    const bool check1 = initialized == 1 && pool.IdleCount() == 1;
+    {
+        auto lease = pool.Acquire();
+        (*lease)["bump"]();
+        (*lease)["bump"]();
+        if (!((*lease)["counter"] == 2)) return false;
+    }
+    auto lease = pool.Acquire();
+    const bool check2 = initialized == 1 && pool.IdleCount() == 0;
+    return check1 && check2 && (*lease)["counter"] == 0;
+}
+
+bool test_state_pool_resets_globals(sel::State &) {
+    sel::StatePool pool([](sel::State &state) {
+        state("x = 1");
+    });
+    {
+        auto lease = pool.Acquire();
+        (*lease)("x = 2 y = 3 print = nil");
+    }
+    auto lease = pool.Acquire();
+    (*lease)("has_print = print ~= nil");
+    return (*lease)["x"] == 1 && !(*lease)["y"].exists() &&
+        (*lease)["has_print"] == true && lease->Size() == 0;
+}
+
+bool test_state_pool_replaces_stale_states(sel::State &) {
+    int initialized = 0;
+    sel::StatePool pool([&initialized](sel::State &state) {
+        ++initialized;
+        state("x = 1");
+    });
+    {
+        auto lease = pool.Acquire();
+        (*lease)("x = 2");
+        lease->Snapshot();
+        (*lease)("y = 3");
+    }
+    auto lease = pool.Acquire();
+    return initialized == 2 && (*lease)["x"] == 1 && !(*lease)["y"].exists();
+}
+
+bool test_state_pool_resets_settings(sel::State &) {
+    int initializer_errors = 0;
+    sel::StatePool pool([&initializer_errors](sel::State &state) {
+        state.HandleExceptionsWith([&initializer_errors](int, std::string, std::exception_ptr) {
+            ++initializer_errors;
+        });
+    });
+    int lessee_errors = 0;
+    {
+        auto lease = pool.Acquire();
+        lease->HandleExceptionsWith([&lessee_errors](int, std::string, std::exception_ptr) {
+            ++lessee_errors;
+        });
+        lease->SetTeardown(sel::Teardown::Abandon);
+        lease->EnableChunkCache(4);
+        lease->Run("x", "x = 1");
+    }
+    auto lease = pool.Acquire();
+    (*lease)("error('from the next lessee')");
+    lease->Run("x", "x = 2");
+    const sel::ChunkCacheStats &stats = lease->ChunkStats();
+    return lessee_errors == 0 && initializer_errors == 1 &&
+        (*lease)["x"] == 2 && stats.hits == 0;
+}
+
+bool test_state_pool_factory(sel::State &) {
+    sel::StatePool pool([]() {
+        std::unique_ptr<sel::State> state{
+            new sel::State{sel::make_unique<sel::PoolAllocator>(), true}};
+        state->GetAllocator()->SetMemoryLimits(0, 16 * 1024 * 1024);
+        return state;
+    }, [](sel::State &state) {
+        state("x = 1");
+    });
+    auto lease = pool.Acquire();
+    return lease->GetAllocator() != nullptr && (*lease)["x"] == 1;
+}
+
+bool test_snapshot_restore(sel::State &state) {
+    state("x = 1 config = {level = 1} function get_x() return x end");
+    auto snapshot = state.Snapshot();
+    state("x = 2 y = 3 config = nil get_x = nil");
+    const bool check1 = state["x"] == 2 && state["y"] == 3;
+    const bool restored = state.Restore(snapshot);
+    state("result = get_x()");
+    return check1 && restored && state["result"] == 1 &&
+        !state["y"].exists() && state["config"]["level"] == 1;
+}
+
+bool test_snapshot_shallow_keeps_nested_changes(sel::State &state) {
+    state("config = {level = 1}");
+    auto snapshot = state.Snapshot();
+    state("config.level = 2");
+    state.Restore(snapshot);
+    return state["config"]["level"] == 2;
+}
+
+bool test_snapshot_deep(sel::State &state) {
+    state("config = {level = 1, nested = {name = 'a'}}");
+    auto snapshot = state.Snapshot(true);
+    state("config.level = 2 config.extra = true config.nested.name = 'b'");
+    state.Restore(snapshot);
+    return state["config"]["level"] == 1 && !state["config"]["extra"].exists() &&
+        state["config"]["nested"]["name"] == "a";
+}
+
+bool test_snapshot_stale(sel::State &state) {
+    state("x = 1");
+    auto first = state.Snapshot();
+    state("x = 2");
+    auto second = state.Snapshot();
+    state("x = 3");
+    const bool stale = !state.Restore(first);
+    const bool latest = state.Restore(second);
+    return stale && latest && state["x"] == 2;
+}
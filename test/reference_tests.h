@@ -60,6 +60,33 @@ bool test_call_multivalue_lua_function(sel::State &state) {
     return lua_add() == std::make_tuple(1, 2);
 }
 
+bool test_copied_function_outlives_original(sel::State &state) {
+    state.Load("../test/test_ref.lua");
+    std::unique_ptr<sel::function<int(int, int)>> original{
+        new sel::function<int(int, int)>(state["add"])};
+    sel::function<int(int, int)> copy = *original;
+    original.reset();
+    state("add = nil");
+    state.ForceGC();
+    return copy(2, 4) == 6;
+}
+
+bool test_copied_reference_outlives_original(sel::State &state) {
+    using namespace test_lifetime;
+    state["Obj"].SetClass<InstanceCounter>();
+    state("obj = Obj.new()");
+    int const instanceCount = InstanceCounter::instances;
+
+    std::unique_ptr<sel::Reference<InstanceCounter>> original{
+        new sel::Reference<InstanceCounter>(state["obj"])};
+    sel::Reference<InstanceCounter> copy = *original;
+    original.reset();
+    state("obj = nil");
+    state.ForceGC();
+
+    return InstanceCounter::instances == instanceCount;
+}
+
 bool test_call_result_is_alive_ptr(sel::State &state) {
     using namespace test_lifetime;
     state["Obj"].SetClass<InstanceCounter>();
@@ -33,6 +33,19 @@ bool test_select_nested_index(sel::State &state) {
     return answer == -3;
 }
 
+bool test_select_name_kinds(sel::State &state) {
+    state("a_rather_long_table_name = {a_rather_long_field_name = 7}");
+    const std::string table = "a_rather_long_table_name";
+    char field[] = "a_rather_long_field_name";
+    const char *field_ptr = field;
+    const bool check1 = state["a_rather_long_table_name"]["a_rather_long_field_name"] == 7;
+    const bool check2 = state[table.c_str()][field] == 7;
+    auto selector = state[table.c_str()][std::string{field}];
+    field[0] = 'x';
+    const bool check3 = selector == 7 && !state[table.c_str()][field_ptr].exists();
+    return check1 && check2 && check3;
+}
+
 bool test_select_equality(sel::State &state) {
     state.Load("../test/test.lua");
     return state["my_table"]["nested"][2] == -3;
@@ -84,6 +97,16 @@ bool test_create_table_index(sel::State &state) {
     return state["new_table"][3] == 4;
 }
 
+bool test_read_does_not_create_table(sel::State &state) {
+    bool is_nil = !state["new_table"]["nested"]["test"].exists();
+    return is_nil && !state["new_table"].exists();
+}
+
+bool test_create_deep_table_field(sel::State &state) {
+    state["new_table"]["a"]["b"]["c"]["d"]["e"]["f"]["g"] = 4;
+    return state["new_table"]["a"]["b"]["c"]["d"]["e"]["f"]["g"] == 4;
+}
+
 bool test_cache_selector_field_assignment(sel::State &state) {
     sel::Selector s = state["new_table"][3];
     s = 4;
@@ -307,3 +330,155 @@ bool test_selector_get_wrong_ptr(sel::State &state) {
     SelectorFoo * foo = state["bar"];
     return foo == nullptr;
 }
+
+bool test_bound_selector_get(sel::State &state) {
+    state.Load("../test/test.lua");
+    auto foo = state["my_table"]["nested"]["foo"].Bind();
+    auto index = state["my_table"]["nested"][2].Bind();
+    return foo.Get<std::string>() == "bar" && index.Get<int>() == -3;
+}
+
+bool test_bound_selector_set(sel::State &state) {
+    state.Load("../test/test.lua");
+    auto key = state["my_table"]["nested"]["asdf"].Bind();
+    key.Set(7);
+    return state["my_table"]["nested"]["asdf"] == 7 && key.Get<int>() == 7;
+}
+
+bool test_bound_selector_invalidate(sel::State &state) {
+    state("cfg = {net = {port = 80}}");
+    auto port = state["cfg"]["net"]["port"].Bind();
+    bool check1 = port.Get<int>() == 80;
+    state("cfg.net = {port = 8080}");
+    bool check2 = port.Get<int>() == 80;
+    port.Invalidate();
+    bool check3 = port.Get<int>() == 8080;
+    return check1 && check2 && check3;
+}
+
+bool test_selector_call(sel::State &state) {
+    state.Load("../test/test.lua");
+    return state["add"].Call<int>(5, 2) == 7;
+}
+
+bool test_selector_call_no_return(sel::State &state) {
+    state.Load("../test/test.lua");
+    state["set_global"].Call();
+    return state["global1"] == 8;
+}
+
+bool test_selector_call_multi_return(sel::State &state) {
+    state.Load("../test/test.lua");
+    auto result = state["sum_and_difference"].Call<std::tuple<int, int>>(3, 1);
+    return result == std::make_tuple(4, 2);
+}
+
+bool test_selector_call_field(sel::State &state) {
+    state.Load("../test/test.lua");
+    return state["mytable"]["foo"].Call<int>() == 4;
+}
+
+bool test_selector_call_error(sel::State &state) {
+    state.Load("../test/test.lua");
+    int luaStatusCode = LUA_OK;
+    state.HandleExceptionsWith([&luaStatusCode](int s, std::string, std::exception_ptr) {
+        luaStatusCode = s;
+    });
+    state["undefined_function"].Call(1, 2);
+    return luaStatusCode == LUA_ERRRUN;
+}
+
+bool test_batched_calls(sel::State &state) {
+    state.Load("../test/test.lua");
+    sel::function<int(int, int)> add = state["add"];
+    int sum = 0;
+    {
+        auto batch = state.BatchCalls();
+        for (int i = 0; i < 10; ++i) {
+            sum += state["add"].Call<int>(i, 1);
+            sum += add(i, 1);
+            sum += int(state["add"](i, 1));
+        }
+    }
+    return sum == 3 * 55;
+}
+
+bool test_batched_calls_error(sel::State &state) {
+    state.Load("../test/test.lua");
+    int luaStatusCode = LUA_OK;
+    state.HandleExceptionsWith([&luaStatusCode](int s, std::string, std::exception_ptr) {
+        luaStatusCode = s;
+    });
+    auto batch = state.BatchCalls();
+    state["undefined_function"].Call();
+    bool check1 = luaStatusCode == LUA_ERRRUN;
+    bool check2 = state["add"].Call<int>(1, 2) == 3;
+    return check1 && check2;
+}
+
+bool test_batched_calls_replace_handler(sel::State &state) {
+    state.Load("../test/test.lua");
+    auto batch = state.BatchCalls();
+    const int top = state.Size();
+    int luaStatusCode = LUA_OK;
+    state.HandleExceptionsWith([&luaStatusCode](int s, std::string, std::exception_ptr) {
+        luaStatusCode = s;
+    });
+    state["undefined_function"].Call();
+    const bool check1 = luaStatusCode == LUA_ERRRUN;
+    // Calls keep reusing the handler pinned by the batch
+    const bool check2 = state["add"].Call<int>(1, 2) == 3 && state.Size() == top;
+    return check1 && check2;
+}
+
+bool test_table_size(sel::State &state) {
+    state("t = {1, 2, 3, x = 4}; s = 'abc'");
+    return state["t"].Size() == 3 && state["s"].Size() == 0 &&
+        state["missing"].Size() == 0;
+}
+
+bool test_table_for_each(sel::State &state) {
+    state("t = {a = 1, b = 2, c = 3}; list = {10, 20}");
+    int sum = 0;
+    std::string keys;
+    state["t"].ForEach<std::string, int>([&sum, &keys](std::string key, int value) {
+        keys += key;
+        sum += value;
+    });
+    int index_sum = 0;
+    state["list"].ForEach<std::string, int>([&index_sum](std::string key, int value) {
+        index_sum += value * (key == "2" ? 2 : 1);
+    });
+    return sum == 6 && keys.size() == 3 && index_sum == 50 && state.Size() == 0;
+}
+
+bool test_table_pairs_number_key_views(sel::State &state) {
+    state("t = {10, 20}");
+    std::string keys;
+    int sum = 0;
+    for (auto entry : state["t"].Pairs()) {
+        const sel::string_view key = entry.Key<sel::string_view>();
+        sum += entry.Value<int>();
+        keys += key.str();
+    }
+    return keys == "12" && sum == 30 && state.Size() == 0;
+}
+
+bool test_table_pairs(sel::State &state) {
+    state("t = {x = 1.5, y = 2.5}");
+    lua_Number sum = 0;
+    int count = 0;
+    {
+        auto pairs = state["t"].Pairs();
+        for (auto entry : pairs) {
+            sum += entry.Value<lua_Number>();
+            ++count;
+        }
+    }
+    int empty = 0;
+    for (auto entry : state["missing"].Pairs()) {
+        (void)entry;
+        ++empty;
+    }
+    return sum == 4 && count == 2 && empty == 0 && state.Size() == 0;
+}
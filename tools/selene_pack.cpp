@@ -0,0 +1,91 @@
+// Packs the .lua files of a directory into a bundle for State::LoadBundle:
+//
+//     selene_pack <bundle> <directory>
+//
+// Every script is compiled to bytecode. "a/b/c.lua" becomes the module
+// "a.b.c" and "a/b/init.lua" the module "a.b", like the default
+// package.path entries "?.lua" and "?/init.lua".
+#include <algorithm>
+#include <dirent.h>
+#include <iostream>
+#include <selene.h>
+#include <string>
+#include <sys/stat.h>
+#include <utility>
+#include <vector>
+
+namespace {
+
+bool ends_with(const std::string &s, const std::string &suffix) {
+    return s.size() >= suffix.size() &&
+        s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+// Relative paths of all .lua files below directory
+bool find_scripts(const std::string &directory, const std::string &prefix,
+                  std::vector<std::string> &scripts) {
+    DIR *dir = opendir(directory.c_str());
+    if (dir == nullptr) return false;
+    while (dirent *entry = readdir(dir)) {
+        const std::string name = entry->d_name;
+        if (name == "." || name == "..") continue;
+        const std::string path = directory + "/" + name;
+        struct stat info;
+        if (stat(path.c_str(), &info) != 0) continue;
+        if (S_ISDIR(info.st_mode)) {
+            find_scripts(path, prefix + name + "/", scripts);
+        } else if (S_ISREG(info.st_mode) && ends_with(name, ".lua")) {
+            scripts.push_back(prefix + name);
+        }
+    }
+    closedir(dir);
+    return true;
+}
+
+std::string module_name(std::string relative) {
+    relative.resize(relative.size() - 4);
+    if (relative == "init") return relative;
+    if (ends_with(relative, "/init")) relative.resize(relative.size() - 5);
+    std::replace(relative.begin(), relative.end(), '/', '.');
+    return relative;
+}
+
+}
+
+int main(int argc, char **argv) {
+    if (argc != 3) {
+        std::cerr << "usage: " << argv[0] << " <bundle> <directory>" << std::endl;
+        return 2;
+    }
+    const std::string output = argv[1];
+    const std::string directory = argv[2];
+
+    std::vector<std::string> scripts;
+    if (!find_scripts(directory, "", scripts)) {
+        std::cerr << "cannot open directory " << directory << std::endl;
+        return 1;
+    }
+    std::sort(scripts.begin(), scripts.end());
+
+    sel::State state;
+    bool failed = false;
+    state.HandleExceptionsWith([&failed](int, std::string msg, std::exception_ptr) {
+        std::cerr << msg << std::endl;
+        failed = true;
+    });
+
+    sel::BundleWriter writer;
+    for (const auto &script : scripts) {
+        const std::string bytecode = state.Compile(directory + "/" + script);
+        if (bytecode.empty()) continue;
+        writer.Add(module_name(script), bytecode);
+    }
+    if (failed) return 1;
+
+    if (!writer.Write(output)) {
+        std::cerr << "cannot write " << output << std::endl;
+        return 1;
+    }
+    std::cout << "packed " << scripts.size() << " modules into " << output << std::endl;
+    return 0;
+}